@@ -13,24 +13,38 @@
 
 /* System headers. */
 
-#include <cstdlib>
+#include <cassert>
 #include <cstring>
 
 
 /* Local headers. */
 
 #include "picosystem.hpp"
+#include "engine/board.hpp"
+#include "engine/game.hpp"
+#include "engine/rng.hpp"
+#include "engine/search.hpp"
 #include "assets/spritesheet.hpp"
 #include "assets/logo_ahnlak_1bit.hpp"
 
 
 /* Local structures and types. */
 
+/* The board size can be overridden at build time, for experiments. */
+#ifndef GAME_BOARD_WIDTH
+#define GAME_BOARD_WIDTH  4
+#endif
+#ifndef GAME_BOARD_HEIGHT
+#define GAME_BOARD_HEIGHT 4
+#endif
+
+typedef Board<GAME_BOARD_WIDTH, GAME_BOARD_HEIGHT> board_t;
+
 typedef struct
 {
   uint_fast8_t  row;
   uint_fast8_t  col;
-  uint16_t      value;
+  uint_fast8_t  value;
   uint_fast8_t  progress;
 } spawn_t;
 
@@ -40,9 +54,10 @@ typedef struct
   uint_fast8_t  start_col;
   uint_fast8_t  end_row;
   uint_fast8_t  end_col;
-  uint16_t      start_value;
-  uint16_t      end_value;
+  uint_fast8_t  start_value;
+  uint_fast8_t  end_value;
   uint_fast8_t  pixels_to_end;
+  bool          record;
 } move_t;
 
 typedef struct 
@@ -54,20 +69,36 @@ typedef struct
 
 /* Globals (shhh!) */
 
-#define BOARD_WIDTH   4
-#define BOARD_HEIGHT  4
-#define MOVE_MAX      12
+#define MOVE_MAX      ( board_t::cells )
 #define TUNE_LENGTH   16
+#define VICTORY_EXP   11
+
+/* Cells share out the screen; sprites are 56 pixels square, four to a */
+/* row of the spritesheet, and are scaled down if the cells are small.  */
+#define SPRITE_SIZE   56
+#define SPRITE_COLS   4
+#define CELL_PITCH    ( 240 / ( ( GAME_BOARD_WIDTH > GAME_BOARD_HEIGHT ) ? GAME_BOARD_WIDTH : GAME_BOARD_HEIGHT ) )
+#define CELL_SIZE     ( ( CELL_PITCH - 4 < SPRITE_SIZE ) ? CELL_PITCH - 4 : SPRITE_SIZE )
+#define CELL_INSET    ( ( CELL_PITCH - CELL_SIZE ) / 2 )
+
+/* Y asks the search for a move and plays it, so tapping it away lets the */
+/* game play itself; the search is given time rather than a depth, and    */
+/* half of the 20ms a frame has, so drawing the frame still fits in.      */
+#define HINT_BUDGET_US  10000
+#define HINT_DEPTH      4
 
 bool                g_playing = false;
 bool                g_moving = false;
-uint16_t            g_cells[BOARD_HEIGHT][BOARD_WIDTH];
+board_t             g_board;
+game_t<board_t>     g_game;
+uint64_t            g_seed;
+rng_t               g_fx_rng;
 spawn_t             g_spawn;
 move_t              g_moves[MOVE_MAX];
 bool                g_splashing = true;
 uint_fast8_t        g_splash_tone = 0;
 picosystem::voice_t g_voice;
-uint16_t            g_max_cell = 0;
+uint_fast8_t        g_max_cell = 0;
 note_t              g_tune[TUNE_LENGTH];
 uint_fast8_t        g_tune_note = TUNE_LENGTH;
 uint_fast8_t        g_tune_note_count = TUNE_LENGTH;
@@ -86,15 +117,9 @@ uint_fast8_t        g_flash_mute = 0;
 
 void board_clear( void )
 {
-  /* Work through rows. */
-  for( uint_fast8_t l_row = 0; l_row < BOARD_HEIGHT; l_row++ )
-  {
-    /* And then columns. */
-    for( uint_fast8_t l_col = 0; l_col < BOARD_WIDTH; l_col++ )
-    {
-      g_cells[l_row][l_col] = 0;
-    }
-  }
+  /* The displayed board empties in one go; the game itself is reset */
+  /* separately, when it's given a seed.                             */
+  g_board = {};
 
   /* Make sure the spawn isn't active. */
   g_spawn.progress = 100;
@@ -105,12 +130,13 @@ void board_clear( void )
     g_moves[l_index].pixels_to_end = 0;
   }
 
-  /* Reset the max cell record. */
-  g_max_cell = 2;
+  /* Reset the max cell record (held as an exponent); the first spawn */
+  /* sets it, from the game.                                          */
+  g_max_cell = 0;
 
   /* And flag the victory conditions as not yet reached. */
-  g_victory_row = BOARD_HEIGHT;
-  g_victory_col = BOARD_WIDTH;
+  g_victory_row = board_t::height;
+  g_victory_col = board_t::width;
 
   /* All done. */
   return;
@@ -124,435 +150,196 @@ void board_clear( void )
 
 bool board_spawn( void )
 {
-  uint_fast8_t l_free_cell_count = 0;
-  uint_fast8_t l_free_cells[BOARD_HEIGHT*BOARD_WIDTH];
+  spawn_pick_t l_pick;
 
-  /* Quickly scan the empty cells. */
-  for( uint_fast8_t l_row = 0; l_row < BOARD_HEIGHT; l_row++ )
+  /* The game picks the cell and value; if there's no room, it's a fail. */
+  if ( !game_spawn( &g_game, &l_pick ) )
   {
-    /* And then columns. */
-    for( uint_fast8_t l_col = 0; l_col < BOARD_WIDTH; l_col++ )
-    {
-      /* Skip any cells on the board which are filled. */
-      if ( g_cells[l_row][l_col] > 0 )
-      {
-        continue;
-      }
-
-      /* We also need to check any active moves. */
-      for ( uint_fast8_t l_index = 0; l_index < MOVE_MAX; l_index++ )
-      {
-        if ( ( g_moves[l_index].pixels_to_end > 0 ) &&
-             ( g_moves[l_index].end_row == l_row ) && ( g_moves[l_index].end_col == l_col ) )
-        {
-          continue;
-        }
-      }
-
-      /* Good, then it's free! */
-      l_free_cells[l_free_cell_count++] = ( l_row * BOARD_WIDTH ) + l_col;
-    }
+    return false;
   }
 
-  /* So, if we found no free cell, it's a fail. */
-  if ( l_free_cell_count == 0 )
+  /* A spawned '4' can raise the record too, though without a fanfare. */
+  if ( g_game.max_exponent > g_max_cell )
   {
-    return false;
+    g_max_cell = g_game.max_exponent;
   }
 
-  /* Select a random cell from that array then. */
-  uint_fast8_t l_free_cell = l_free_cells[std::rand()%l_free_cell_count];
-
-  /* And fill that in. */
-  //g_cells[l_free_cell/BOARD_WIDTH][l_free_cell%BOARD_WIDTH] = 2;
-  g_spawn.row = l_free_cell/BOARD_WIDTH;
-  g_spawn.col = l_free_cell%BOARD_WIDTH;
-  g_spawn.value = 2;
+  /* And animate it in. */
+  g_spawn.row = l_pick.cell/board_t::width;
+  g_spawn.col = l_pick.cell%board_t::width;
+  g_spawn.value = l_pick.exponent;
   g_spawn.progress = 0;
   return true;
 }
 
 
 /*
- * board_move - responds to the user choosing a direction; takes a button
- *              direction, and returns true if a move is possible.
+ * board_hint - asks the search for the best move on the board, within the
+ *              hint budget; DIRECTION_COUNT if there isn't one.
  */
 
-bool board_move( uint_fast8_t p_direction )
+direction_t board_hint( void )
 {
-  bool          l_success = false, l_collapsed = false;
-  int_fast8_t   l_row, l_col, l_altrow, l_altcol;
-  move_t        l_move;
-  uint16_t      l_workrow[BOARD_WIDTH], l_workcol[BOARD_HEIGHT];
-
-  /* Work through each direction; this could be genericised into vectors, */
-  /* but to be honest it's not worth the effort!                          */
-  switch( p_direction )
-  {
-  case picosystem::UP:
-    /* Work through every row. */
-    for( l_col = 0; l_col < BOARD_WIDTH; l_col++ )
-    {
-      /* Only allow one collapse per row. */
-      l_collapsed = false;
-
-      /* And we will work on a copy of the column, for ease of fiddling. */
-      for ( uint_fast8_t l_index = 0; l_index < BOARD_HEIGHT; l_index++ )
-      {
-        l_workcol[l_index] = g_cells[l_index][l_col];
-      }
-      
-      /* And each row in that column. */
-      for( l_row = 1; l_row < BOARD_HEIGHT; l_row++ )
-      {
-        /* Set up the potential move. */
-        l_move.start_row = l_move.end_row = l_row;
-        l_move.start_col = l_move.end_col = l_col;
-        l_move.start_value = l_move.end_value = l_workcol[l_row];
-        l_move.pixels_to_end = 0;
-
-        /* If this cell isn't empty, run some checks. */
-        if ( l_workcol[l_row] > 0 )
-        {
-          /* Well then, can we move up any? */
-          for ( l_altrow = l_row - 1; l_altrow >= 0; l_altrow-- )
-          {
-            /* Jump out if the cell is occupied. */
-            if ( l_workcol[l_altrow] > 0 )
-            {
-              break;
-            }
-
-            /* Then shuffle up and carry on. */
-            l_workcol[l_altrow] = l_workcol[l_altrow+1];
-            l_workcol[l_altrow+1] = 0;
-
-            /* And add the step to the move. */
-            l_move.end_row--;
-            l_move.pixels_to_end += 60;
-          }
-
-          /* Can we collapse into the cell next to us? */
-          if ( !l_collapsed && l_workcol[l_altrow] == l_workcol[l_altrow+1] )
-          {
-            /* Keep the work column updated. */
-            l_workcol[l_altrow] *= 2;
-            l_workcol[l_altrow+1] = 0;
-            l_collapsed = true;
-
-            /* And the move. */
-            l_move.end_row--;
-            l_move.end_value *= 2;
-            l_move.pixels_to_end += 60;
-          }
-        }
+  search_options_t l_options = search_options( HINT_DEPTH );
 
-        /* And lastly, add the move into the queue. */
-        if ( l_move.pixels_to_end > 0 )
-        {
-          /* Find an empty slot. */
-          for ( uint_fast8_t l_index = 0; l_index < MOVE_MAX; l_index++ )
-          {
-            if ( g_moves[l_index].pixels_to_end == 0 )
-            {
-              /* So fill it! */
-              memcpy( &g_moves[l_index], &l_move, sizeof( move_t ) );
+  return search_timed( g_game.board, g_game.hash, &l_options, HINT_BUDGET_US ).direction;
+}
 
-              /* And clear the start slot. */
-              g_cells[l_move.start_row][l_move.start_col] = 0;
 
-              /* And we're done. */
-              break;
-            }
-          }
-        }
-      }
-    }
-    break;
-  case picosystem::DOWN:
-    /* Work through every column. */
-    for( l_col = 0; l_col < BOARD_WIDTH; l_col++ )
-    {
-      /* Only allow one collapse per column. */
-      l_collapsed = false;
-
-      /* And we will work on a copy of the column, for ease of fiddling. */
-      for ( uint_fast8_t l_index = 0; l_index < BOARD_HEIGHT; l_index++ )
-      {
-        l_workcol[l_index] = g_cells[l_index][l_col];
-      }
-      
-      /* And each row in that column. */
-      for( l_row = BOARD_HEIGHT-2; l_row >= 0; l_row-- )
-      {
-        /* Set up the potential move. */
-        l_move.start_row = l_move.end_row = l_row;
-        l_move.start_col = l_move.end_col = l_col;
-        l_move.start_value = l_move.end_value = l_workcol[l_row];
-        l_move.pixels_to_end = 0;
-
-        /* If this cell isn't empty, run some checks. */
-        if ( l_workcol[l_row] > 0 )
-        {
-          /* Well then, can we move down any? */
-          for ( l_altrow = l_row + 1; l_altrow < BOARD_HEIGHT; l_altrow++ )
-          {
-            /* Jump out if the cell is occupied. */
-            if ( l_workcol[l_altrow] > 0 )
-            {
-              break;
-            }
+/*
+ * board_move - responds to the user choosing a direction; takes a board
+ *              direction, and returns true if a move is possible.
+ */
 
-            /* Then shuffle down and carry on. */
-            l_workcol[l_altrow] = l_workcol[l_altrow-1];
-            l_workcol[l_altrow-1] = 0;
+bool board_move( direction_t p_direction )
+{
+  bool                    l_vertical, l_reverse;
+  uint_fast8_t            l_record = 0, l_slot = 0, l_lines, l_length;
+  move_result_t<board_t>  l_moved;
+  move_t                  l_move;
+  row_t                   l_line, l_travels;
+  board_t                 l_start = g_game.board;
 
-            /* And add the step to the move. */
-            l_move.end_row++;
-            l_move.pixels_to_end += 60;
-          }
+  /* Make the logical move, if it's allowed; the game keeps its own  */
+  /* board, empty cells, hash and score up to date as it goes.       */
+  if ( !game_move( &g_game, p_direction, &l_moved ) )
+  {
+    return false;
+  }
 
-          /* Can we collapse into the cell next to us? */
-          if ( !l_collapsed && l_workcol[l_altrow] == l_workcol[l_altrow-1] )
-          {
-            /* Keep the work row updated. */
-            l_workcol[l_altrow] *= 2;
-            l_workcol[l_altrow-1] = 0;
-            l_collapsed = true;
-
-            /* And the move. */
-            l_move.end_row++;
-            l_move.end_value *= 2;
-            l_move.pixels_to_end += 60;
-          }
-        }
+  /* The game also tells us if the move set a new record; the fanfare */
+  /* waits for the record tile to land, though.                        */
+  if ( g_game.max_exponent > g_max_cell )
+  {
+    g_max_cell = l_record = g_game.max_exponent;
+  }
 
-        /* And lastly, add the move into the queue. */
-        if ( l_move.pixels_to_end > 0 )
-        {
-          /* Find an empty slot. */
-          for ( uint_fast8_t l_index = 0; l_index < MOVE_MAX; l_index++ )
-          {
-            if ( g_moves[l_index].pixels_to_end == 0 )
-            {
-              /* So fill it! */
-              memcpy( &g_moves[l_index], &l_move, sizeof( move_t ) );
+  /* Rows slide for LEFT and RIGHT, columns for UP and DOWN; reversed */
+  /* lines are the ones heading for their last cell.                   */
+  l_vertical = ( p_direction == DIRECTION_UP ) || ( p_direction == DIRECTION_DOWN );
+  l_reverse = ( p_direction == DIRECTION_DOWN ) || ( p_direction == DIRECTION_RIGHT );
+  l_lines = l_vertical ? board_t::width : board_t::height;
+  l_length = l_vertical ? board_t::height : board_t::width;
 
-              /* And clear the start slot. */
-              g_cells[l_move.start_row][l_move.start_col] = 0;
+  /* Now queue up the animations, one line (row or column) at a time, */
+  /* straight from the travel tables.                                  */
+  for ( uint_fast8_t l_index = 0; l_index < l_lines; l_index++ )
+  {
+    l_line = l_vertical ? l_start.column( l_index ) : l_start.row( l_index );
+    l_travels = l_vertical ? board_row_travels<board_t::height>( l_line, l_reverse )
+                           : board_row_travels<board_t::width>( l_line, l_reverse );
 
-              /* And we're done. */
-              break;
-            }
-          }
-        }
-      }
-    }
-    break;
-  case picosystem::LEFT:
-    /* Work through every row. */
-    for( l_row = 0; l_row < BOARD_HEIGHT; l_row++ )
+    /* Each line is walked from the edge tiles move towards, lead tile first. */
+    for ( uint_fast8_t l_step = 0; l_step < l_length; l_step++ )
     {
-      /* Only allow one collapse per row. */
-      l_collapsed = false;
+      uint_fast8_t l_cell = l_reverse ? l_length - 1 - l_step : l_step;
+      uint_fast8_t l_travel = ROW_TRAVEL( l_travels, l_cell );
+      int_fast8_t  l_distance = l_travel & ROW_TRAVEL_DISTANCE_MASK;
 
-      /* And we will work on a copy of the row, for ease of fiddling. */
-      for ( uint_fast8_t l_index = 0; l_index < BOARD_WIDTH; l_index++ )
+      /* Only tiles that actually go somewhere need animating. */
+      if ( l_distance == 0 )
       {
-        l_workrow[l_index] = g_cells[l_row][l_index];
+        continue;
       }
-      
-      /* And each column in that row. */
-      for( l_col = 1; l_col < BOARD_WIDTH; l_col++ )
+      if ( !l_reverse )
       {
-        /* Set up the potential move. */
-        l_move.start_row = l_move.end_row = l_row;
-        l_move.start_col = l_move.end_col = l_col;
-        l_move.start_value = l_move.end_value = l_workrow[l_col];
-        l_move.pixels_to_end = 0;
-
-        /* If this cell isn't empty, run some checks. */
-        if ( l_workrow[l_col] > 0 )
-        {
-          /* Well then, can we move to the left any? */
-          for ( l_altcol = l_col - 1; l_altcol >= 0; l_altcol-- )
-          {
-            /* Jump out if the cell is occupied. */
-            if ( l_workrow[l_altcol] > 0 )
-            {
-              break;
-            }
-
-            /* Then shuffle to the left and carry on. */
-            l_workrow[l_altcol] = l_workrow[l_altcol+1];
-            l_workrow[l_altcol+1] = 0;
-
-            /* And add the step to the move. */
-            l_move.end_col--;
-            l_move.pixels_to_end += 60;
-          }
+        l_distance = -l_distance;
+      }
 
-          /* Can we collapse into the cell next to us? */
-          if ( !l_collapsed && l_workrow[l_altcol] == l_workrow[l_altcol+1] )
-          {
-            /* Keep the work row updated. */
-            l_workrow[l_altcol] *= 2;
-            l_workrow[l_altcol+1] = 0;
-            l_collapsed = true;
-
-            /* And the move. */
-            l_move.end_col--;
-            l_move.end_value *= 2;
-            l_move.pixels_to_end += 60;
-          }
-        }
+      /* Set up the move, bumping the value if it merges on arrival. */
+      l_move.start_row = l_vertical ? l_cell : l_index;
+      l_move.start_col = l_vertical ? l_index : l_cell;
+      l_move.end_row = l_move.start_row + ( l_vertical ? l_distance : 0 );
+      l_move.end_col = l_move.start_col + ( l_vertical ? 0 : l_distance );
+      l_move.start_value = l_move.end_value = ( l_line >> ( l_cell * BOARD_CELL_BITS ) ) & BOARD_CELL_MASK;
+      l_move.pixels_to_end = ( l_travel & ROW_TRAVEL_DISTANCE_MASK ) * CELL_PITCH;
+      l_move.record = false;
+      if ( l_travel & ROW_TRAVEL_MERGED )
+      {
+        l_move.end_value++;
 
-        /* And lastly, add the move into the queue. */
-        if ( l_move.pixels_to_end > 0 )
+        /* Only the first tile to reach a new record gets a fanfare. */
+        if ( l_move.end_value == l_record )
         {
-          /* Find an empty slot. */
-          for ( uint_fast8_t l_index = 0; l_index < MOVE_MAX; l_index++ )
-          {
-            if ( g_moves[l_index].pixels_to_end == 0 )
-            {
-              /* So fill it! */
-              memcpy( &g_moves[l_index], &l_move, sizeof( move_t ) );
-
-              /* And clear the start slot. */
-              g_cells[l_move.start_row][l_move.start_col] = 0;
-
-              /* And we're done. */
-              break;
-            }
-          }
+          l_move.record = true;
+          l_record = 0;
         }
       }
-    }
-    break;
-  case picosystem::RIGHT:
-    /* Work through every row. */
-    for( l_row = 0; l_row < BOARD_HEIGHT; l_row++ )
-    {
-      /* Only allow one collapse per row. */
-      l_collapsed = false;
 
-      /* And we will work on a copy of the row, for ease of fiddling. */
-      for ( uint_fast8_t l_index = 0; l_index < BOARD_WIDTH; l_index++ )
+      /* Find an empty slot. */
+      while( ( l_slot < MOVE_MAX ) && ( g_moves[l_slot].pixels_to_end != 0 ) )
       {
-        l_workrow[l_index] = g_cells[l_row][l_index];
+        l_slot++;
       }
-      
-      /* And each column in that row. */
-      for( l_col = BOARD_WIDTH-2; l_col >= 0; l_col-- )
+      if ( l_slot < MOVE_MAX )
       {
-        /* Set up the potential move. */
-        l_move.start_row = l_move.end_row = l_row;
-        l_move.start_col = l_move.end_col = l_col;
-        l_move.start_value = l_move.end_value = l_workrow[l_col];
-        l_move.pixels_to_end = 0;
-
-        /* If this cell isn't empty, run some checks. */
-        if ( l_workrow[l_col] > 0 )
-        {
-          /* Well then, can we move to the left any? */
-          for ( l_altcol = l_col + 1; l_altcol < BOARD_WIDTH; l_altcol++ )
-          {
-            /* Jump out if the cell is occupied. */
-            if ( l_workrow[l_altcol] > 0 )
-            {
-              break;
-            }
-
-            /* Then shuffle to the left and carry on. */
-            l_workrow[l_altcol] = l_workrow[l_altcol-1];
-            l_workrow[l_altcol-1] = 0;
+        /* So fill it! */
+        memcpy( &g_moves[l_slot], &l_move, sizeof( move_t ) );
 
-            /* And add the step to the move. */
-            l_move.end_col++;
-            l_move.pixels_to_end += 60;
-          }
-
-          /* Can we collapse into the cell next to us? */
-          if ( !l_collapsed && l_workrow[l_altcol] == l_workrow[l_altcol-1] )
-          {
-            /* Keep the work row updated. */
-            l_workrow[l_altcol] *= 2;
-            l_workrow[l_altcol-1] = 0;
-            l_collapsed = true;
-
-            /* And the move. */
-            l_move.end_col++;
-            l_move.end_value *= 2;
-            l_move.pixels_to_end += 60;
-          }
-        }
-
-        /* And lastly, add the move into the queue. */
-        if ( l_move.pixels_to_end > 0 )
-        {
-          /* Find an empty slot. */
-          for ( uint_fast8_t l_index = 0; l_index < MOVE_MAX; l_index++ )
-          {
-            if ( g_moves[l_index].pixels_to_end == 0 )
-            {
-              /* So fill it! */
-              memcpy( &g_moves[l_index], &l_move, sizeof( move_t ) );
-
-              /* And clear the start slot. */
-              g_cells[l_move.start_row][l_move.start_col] = 0;
-
-              /* And we're done. */
-              break;
-            }
-          }
-        }
+        /* And clear the start slot. */
+        g_board.set_cell( l_move.start_row, l_move.start_col, 0 );
       }
     }
-    break;
   }
 
   /* Return a flag of whether or not we managed to move. */
-  return true; // l_success;
+  return true;
 }
 
 
 /*
  * sprite_row - returns the row co-ordinate of the sprite to use for a given
- *              cell value.
+ *              cell exponent.
  */
 
-uint_fast8_t sprite_row( uint16_t p_cell_value )
+uint_fast16_t sprite_row( uint_fast8_t p_cell_exp )
 {
-  /* There will be faster ways to do this... */
-  if ( p_cell_value <= 16 )
-  {
-    return 0;
-  }
-
-  if ( p_cell_value >= 512 )
+  /* Anything past the last row of tile sprites re-uses it. */
+  if ( p_cell_exp > SPRITE_COLS * 2 )
   {
-    return 112;
+    return SPRITE_SIZE * 2;
   }
 
-  return 56;
+  return ( ( p_cell_exp - 1 ) / SPRITE_COLS ) * SPRITE_SIZE;
 }
 
 
 /*
  * sprite_col - returns the column co-ordinates of the sprite to use for a
- *              given cell value.
+ *              given cell exponent.
+ */
+
+uint_fast16_t sprite_col( uint_fast8_t p_cell_exp )
+{
+  return ( ( p_cell_exp - 1 ) % SPRITE_COLS ) * SPRITE_SIZE;
+}
+
+
+/*
+ * draw_tile - draws the sprite for a cell exponent into the cell whose top
+ *             left corner is at the given screen position. p_shrink trims
+ *             that many sprite pixels off each edge, to draw it smaller.
  */
 
-uint_fast8_t sprite_col( uint16_t p_cell_value )
+void draw_tile( uint_fast8_t p_cell_exp, int32_t p_x, int32_t p_y, uint_fast8_t p_shrink )
 {
-  while( p_cell_value > 16 )
+  int32_t l_size = SPRITE_SIZE - ( p_shrink * 2 );
+
+  /* Cells big enough for the whole sprite just get a straight blit. */
+  if ( CELL_SIZE == SPRITE_SIZE )
   {
-    p_cell_value /= 16;
+    picosystem::blit( &spritesheet_buffer,
+      sprite_col( p_cell_exp ) + p_shrink, sprite_row( p_cell_exp ) + p_shrink, l_size, l_size,
+      p_x + CELL_INSET + p_shrink, p_y + CELL_INSET + p_shrink );
+    return;
   }
-  if ( p_cell_value == 2 ) return 0;
-  if ( p_cell_value == 4 ) return 56;
-  if ( p_cell_value == 8 ) return 112;
-  return 168;
+
+  /* Otherwise, scale it down to fit. */
+  picosystem::blit( &spritesheet_buffer,
+    sprite_col( p_cell_exp ) + p_shrink, sprite_row( p_cell_exp ) + p_shrink, l_size, l_size,
+    p_x + CELL_INSET + ( p_shrink * CELL_SIZE ) / SPRITE_SIZE,
+    p_y + CELL_INSET + ( p_shrink * CELL_SIZE ) / SPRITE_SIZE,
+    ( l_size * CELL_SIZE ) / SPRITE_SIZE, ( l_size * CELL_SIZE ) / SPRITE_SIZE );
 }
 
 
@@ -562,6 +349,10 @@ uint_fast8_t sprite_col( uint16_t p_cell_value )
 
 void init( void )
 {
+  /* In debug builds, make sure the compiler generated the row tables we */
+  /* expected; this is a full scan, so release builds skip it.           */
+  assert( board_verify_tables() );
+
   /* Make sure the board is empty. */
   board_clear();
 
@@ -582,6 +373,10 @@ void init( void )
   /* Remember the time, so we can keep track in updates. */
   g_last_update_us = picosystem::time_us();
 
+  /* Purely decorative randomness comes from its own generator, so that */
+  /* it never disturbs the sequence a game's seed plays out.             */
+  rng_seed( &g_fx_rng, g_last_update_us );
+
   /* All done. */
   return;
 }
@@ -596,7 +391,7 @@ void init( void )
 
 void update( uint32_t p_tick )
 {
-  uint_fast8_t l_direction = 0;
+  direction_t l_direction = DIRECTION_COUNT;
 
   /* We need to keep our own time. */
   uint32_t l_current_us = picosystem::time_us();
@@ -667,6 +462,10 @@ void update( uint32_t p_tick )
       /* Reset the board. */
       board_clear();
 
+      /* Every game gets its own seed; the same seed plays the same game. */
+      g_seed = l_current_us;
+      game_reset( &g_game, g_seed );
+
       /* Spawn a new cell. */
       board_spawn();
 
@@ -706,7 +505,25 @@ void update( uint32_t p_tick )
       g_spawn.progress = 100;
 
       /* And set the cell. */
-      g_cells[g_spawn.row][g_spawn.col] = g_spawn.value;
+      g_board.set_cell( g_spawn.row, g_spawn.col, g_spawn.value );
+
+      /* If the game is stuck, it's over; back to the title screen. */
+      if ( g_game.legal == 0 )
+      {
+        g_playing = false;
+
+        /* With a suitably mournful little tune. */
+        g_tune[0].frequency = 494;
+        g_tune[0].duration = 200;
+        g_tune[1].frequency = 440;
+        g_tune[1].duration = 200;
+        g_tune[2].frequency = 392;
+        g_tune[2].duration = 200;
+        g_tune[3].frequency = 330;
+        g_tune[3].duration = 500;
+        g_tune_note = 0;
+        g_tune_note_count = 4;
+      }
     }
   }
 
@@ -725,15 +542,13 @@ void update( uint32_t p_tick )
       if ( g_moves[l_index].pixels_to_end == 0 )
       {
         /* Record it in the main grid. */
-        g_cells[g_moves[l_index].end_row][g_moves[l_index].end_col] = g_moves[l_index].end_value;
+        g_board.set_cell( g_moves[l_index].end_row, g_moves[l_index].end_col, g_moves[l_index].end_value );
 
         /* Check to see if it's a new record max.*/
-        if ( g_moves[l_index].end_value > g_max_cell )
+        if ( g_moves[l_index].record )
         {
-          g_max_cell = g_moves[l_index].end_value;
-
           /* Check to see if we've maxxed out, in which case... victory! */
-          if ( g_moves[l_index].end_value == 2048 )
+          if ( g_moves[l_index].end_value == VICTORY_EXP )
           {
             /* Remember what cell won it. */
             g_victory_row = g_moves[l_index].end_row;
@@ -762,7 +577,7 @@ void update( uint32_t p_tick )
             /* Don't beep if we're muted. */
             if ( !g_muted )
             {
-              picosystem::play( g_voice, 750 + ( g_max_cell * 2 ), 300, 75 );
+              picosystem::play( g_voice, 750 + ( board_cell_value( g_moves[l_index].end_value ) * 2 ), 300, 75 );
             }
           }
         }
@@ -794,13 +609,13 @@ void update( uint32_t p_tick )
   if ( picosystem::pressed( picosystem::B ) )
   {
     /* Quick n dirty reset; probably shouldn't stay here forever... */
-    g_victory_col = BOARD_WIDTH;
-    g_victory_row = BOARD_HEIGHT;
+    g_victory_col = board_t::width;
+    g_victory_row = board_t::height;
     g_playing = false;
   }
 
   /* That's the only input during victory; no moving! */
-  if ( ( g_victory_col != BOARD_WIDTH) || ( g_victory_row != BOARD_HEIGHT ) )
+  if ( ( g_victory_col != board_t::width ) || ( g_victory_row != board_t::height ) )
   {
     return;
   }
@@ -808,23 +623,29 @@ void update( uint32_t p_tick )
   /* Handle movement. */
   if ( picosystem::pressed( picosystem::UP ) )
   {
-    l_direction = picosystem::UP;
+    l_direction = DIRECTION_UP;
   }
   if ( picosystem::pressed( picosystem::DOWN ) )
   {
-    l_direction = picosystem::DOWN;
+    l_direction = DIRECTION_DOWN;
   }
   if ( picosystem::pressed( picosystem::LEFT ) )
   {
-    l_direction = picosystem::LEFT;
+    l_direction = DIRECTION_LEFT;
   }
   if ( picosystem::pressed( picosystem::RIGHT ) )
   {
-    l_direction = picosystem::RIGHT;
+    l_direction = DIRECTION_RIGHT;
+  }
+
+  /* Or let the search choose. */
+  if ( picosystem::pressed( picosystem::Y ) )
+  {
+    l_direction = board_hint();
   }
 
   /* So, if we have a direction try to apply it. */
-  if ( l_direction != 0 )
+  if ( l_direction != DIRECTION_COUNT )
   {
     board_move( l_direction );
   }
@@ -890,33 +711,35 @@ void draw( uint32_t p_tick )
 
   /* Then draw in the individual cell borders. */
   picosystem::pen( 11, 11, 11 );
-  for( uint_fast8_t l_index = 0; l_index < 5; l_index ++ )
+  for( uint_fast8_t l_index = 0; l_index < board_t::height; l_index ++ )
   {
-    picosystem::hline( 0,    l_index*60, picosystem::SCREEN->w );
-    picosystem::hline( 0, l_index*60+01, picosystem::SCREEN->w );
-    picosystem::hline( 0, l_index*60+58, picosystem::SCREEN->w );
-    picosystem::hline( 0, l_index*60+59, picosystem::SCREEN->w );
-    picosystem::vline( l_index*60,    0, picosystem::SCREEN->h );
-    picosystem::vline( l_index*60+01, 0, picosystem::SCREEN->h );
-    picosystem::vline( l_index*60+58, 0, picosystem::SCREEN->h );
-    picosystem::vline( l_index*60+59, 0, picosystem::SCREEN->h );
+    picosystem::hline( 0,    l_index*CELL_PITCH, picosystem::SCREEN->w );
+    picosystem::hline( 0, l_index*CELL_PITCH+01, picosystem::SCREEN->w );
+    picosystem::hline( 0, l_index*CELL_PITCH+CELL_PITCH-2, picosystem::SCREEN->w );
+    picosystem::hline( 0, l_index*CELL_PITCH+CELL_PITCH-1, picosystem::SCREEN->w );
+  }
+  for( uint_fast8_t l_index = 0; l_index < board_t::width; l_index ++ )
+  {
+    picosystem::vline( l_index*CELL_PITCH,    0, picosystem::SCREEN->h );
+    picosystem::vline( l_index*CELL_PITCH+01, 0, picosystem::SCREEN->h );
+    picosystem::vline( l_index*CELL_PITCH+CELL_PITCH-2, 0, picosystem::SCREEN->h );
+    picosystem::vline( l_index*CELL_PITCH+CELL_PITCH-1, 0, picosystem::SCREEN->h );
   }
 
   /* Work through each cell now, drawing a block if one is present. */
-  for( uint_fast8_t l_row = 0; l_row < BOARD_HEIGHT; l_row++ )
+  for( uint_fast8_t l_row = 0; l_row < board_t::height; l_row++ )
   {
-    for( uint_fast8_t l_col = 0; l_col < BOARD_WIDTH; l_col++ )
+    for( uint_fast8_t l_col = 0; l_col < board_t::width; l_col++ )
     {
       /* So, only have stuff to draw when there's a value. */
-      if ( g_cells[l_row][l_col] == 0 )
+      uint_fast8_t l_cell = g_board.cell( l_row, l_col );
+      if ( l_cell == 0 )
       {
         continue;
       }
 
       /* Draw the value into the cell, at least. */
-      picosystem::blit( &spritesheet_buffer, 
-        sprite_col( g_cells[l_row][l_col] ), sprite_row( g_cells[l_row][l_col] ),
-        56, 56, (l_col * 60) + 2, (l_row * 60) + 2 );
+      draw_tile( l_cell, l_col * CELL_PITCH, l_row * CELL_PITCH, 0 );
     }
   }
 
@@ -926,10 +749,7 @@ void draw( uint32_t p_tick )
     /* Blit it with a suitable offset. */
     uint_fast8_t l_offset = 25 - ( g_spawn.progress / 4 );;
 
-    picosystem::blit( &spritesheet_buffer,
-      sprite_col( g_spawn.value ) + l_offset, sprite_row( g_spawn.value ) + l_offset,
-      56 - ( l_offset * 2 ), 56 - ( l_offset * 2 ),
-      ( g_spawn.col * 60 ) + 2 + l_offset, ( g_spawn.row * 60 ) + 2 + l_offset );
+    draw_tile( g_spawn.value, g_spawn.col * CELL_PITCH, g_spawn.row * CELL_PITCH, l_offset );
   }
 
   /* And work through the moving blocks too. */
@@ -942,8 +762,8 @@ void draw( uint32_t p_tick )
     }
 
     /* Work out where to draw, at the end. */
-    uint_fast8_t l_move_row = ( g_moves[l_index].end_row * 60 ) + 2;
-    uint_fast8_t l_move_col = ( g_moves[l_index].end_col * 60 ) + 2;
+    uint_fast8_t l_move_row = g_moves[l_index].end_row * CELL_PITCH;
+    uint_fast8_t l_move_col = g_moves[l_index].end_col * CELL_PITCH;
 
     /* Horizontal? */
     if ( g_moves[l_index].start_row == g_moves[l_index].end_row )
@@ -974,9 +794,7 @@ void draw( uint32_t p_tick )
     }
 
     /* Good, now we can draw! */
-    picosystem::blit( &spritesheet_buffer,
-      sprite_col( g_moves[l_index].start_value ), sprite_row( g_moves[l_index].start_value ),
-      56, 56, l_move_col, l_move_row );
+    draw_tile( g_moves[l_index].start_value, l_move_col, l_move_row, 0 );
   }
 
   /* If we're not playing, add the title and start prompt. */
@@ -994,21 +812,19 @@ void draw( uint32_t p_tick )
   }
 
   /* And if we're in a victory condition, render something too. */
-  if ( ( g_victory_col != BOARD_WIDTH ) || ( g_victory_row != BOARD_HEIGHT ) )
+  if ( ( g_victory_col != board_t::width ) || ( g_victory_row != board_t::height ) )
   {
     /* Fade the play area back some. */
     picosystem::pen( 6, 6, 6, 10 );
     picosystem::frect( 0, 0, picosystem::SCREEN->w, picosystem::SCREEN->h );
 
     /* Redraw the victory cell brightly. */
-    picosystem::blit( &spritesheet_buffer, 
-      sprite_col( 2048 ), sprite_row( 2048 ), 56, 56, 
-      (g_victory_col * 60) + 2, (g_victory_row * 60) + 2 );
+    draw_tile( VICTORY_EXP, g_victory_col * CELL_PITCH, g_victory_row * CELL_PITCH, 0 );
 
     /* And some suitable "victory" splashes too. */
     picosystem::blit( &spritesheet_buffer, 0, 304, 160, 32, 
-                      std::rand()%(picosystem::SCREEN->w-160),
-                      std::rand()%(picosystem::SCREEN->h-32) );
+                      rng_below( &g_fx_rng, picosystem::SCREEN->w-160 ),
+                      rng_below( &g_fx_rng, picosystem::SCREEN->h-32 ) );
   }
 
   /* The last thing to draw is any flash mute notification, as that is drawn */
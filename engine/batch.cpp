@@ -0,0 +1,149 @@
+/*
+ * engine/batch.cpp; bulk moves for the standard 4x4 board.
+ *
+ * With AVX2, four boards sit side by side in a 256-bit register. Each of
+ * their rows is pulled out with a shift and a mask, and all four looked up
+ * with one gather; the gathers read from a table pairing the LEFT and RIGHT
+ * results of each row in 32 bits, so no read ever strays past its end. The
+ * vertical moves transpose all four boards with the same shifts and masks
+ * as Board::transpose(), just four lanes at a time.
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+/* System headers. */
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined( __AVX2__ )
+#include <immintrin.h>
+#endif
+
+
+/* Local headers. */
+
+#include "batch.hpp"
+
+
+#if defined( __AVX2__ )
+
+/* Constants. */
+
+#define BATCH_LANES 4
+
+static_assert( sizeof( Board<4, 4> ) == sizeof( uint64_t ), "4x4 boards must pack four to a vector" );
+
+
+/* Functions. */
+
+/*
+ * batch_build_pair_table - generates the gather table; the LEFT result of
+ *                          each row in the low half, RIGHT in the high. The
+ *                          row tables are only known to the linker here, so
+ *                          this is done once, at start-up.
+ */
+
+static std::array<uint32_t, 65536> batch_build_pair_table( void )
+{
+  std::array<uint32_t, 65536> l_table = {};
+
+  for ( row_t l_row = 0; l_row < l_table.size(); l_row++ )
+  {
+    l_table[l_row] = row_tables_t<4>::left[l_row] | ( (uint32_t)row_tables_t<4>::right[l_row] << 16 );
+  }
+
+  return l_table;
+}
+
+static const std::array<uint32_t, 65536> g_batch_pairs = batch_build_pair_table();
+
+
+/*
+ * batch_transpose - transposes four 4x4 boards at once.
+ */
+
+static inline __m256i batch_transpose( __m256i p_words )
+{
+  p_words = _mm256_or_si256(
+    _mm256_and_si256( p_words, _mm256_set1_epi64x( 0xF0F00F0FF0F00F0Fll ) ),
+    _mm256_or_si256(
+      _mm256_slli_epi64( _mm256_and_si256( p_words, _mm256_set1_epi64x( 0x0000F0F00000F0F0ll ) ), 12 ),
+      _mm256_srli_epi64( _mm256_and_si256( p_words, _mm256_set1_epi64x( 0x0F0F00000F0F0000ll ) ), 12 ) ) );
+
+  return _mm256_or_si256(
+    _mm256_and_si256( p_words, _mm256_set1_epi64x( (int64_t)0xFF00FF0000FF00FFull ) ),
+    _mm256_or_si256(
+      _mm256_slli_epi64( _mm256_and_si256( p_words, _mm256_set1_epi64x( 0x00000000FF00FF00ll ) ), 24 ),
+      _mm256_srli_epi64( _mm256_and_si256( p_words, _mm256_set1_epi64x( 0x00FF00FF00000000ll ) ), 24 ) ) );
+}
+
+
+/*
+ * batch_slide_rows - slides every row of four 4x4 boards towards cell 0, or
+ *                    towards cell 3 if reversed.
+ */
+
+static inline __m256i batch_slide_rows( __m256i p_words, bool p_reverse )
+{
+  __m256i l_result = _mm256_setzero_si256();
+  __m256i l_row_mask = _mm256_set1_epi64x( 0xFFFF );
+  __m128i l_half_mask = _mm_set1_epi32( 0xFFFF );
+
+  for ( uint_fast8_t l_row = 0; l_row < 4; l_row++ )
+  {
+    __m128i l_shift = _mm_cvtsi32_si128( l_row * 16 );
+    __m256i l_index = _mm256_and_si256( _mm256_srl_epi64( p_words, l_shift ), l_row_mask );
+    __m128i l_pairs = _mm256_i64gather_epi32( (const int *)g_batch_pairs.data(), l_index, 4 );
+    __m128i l_slid = p_reverse ? _mm_srli_epi32( l_pairs, 16 ) : _mm_and_si128( l_pairs, l_half_mask );
+
+    l_result = _mm256_or_si256( l_result, _mm256_sll_epi64( _mm256_cvtepu32_epi64( l_slid ), l_shift ) );
+  }
+
+  return l_result;
+}
+
+#endif /* __AVX2__ */
+
+
+/*
+ * board_move_batch - the 4x4 specialisation; four boards at a time where
+ *                    AVX2 is available, with any leftovers (or everything,
+ *                    elsewhere) done one at a time.
+ */
+
+template<>
+void board_move_batch<4, 4, 4>( direction_t p_direction, const Board<4, 4> *p_in, Board<4, 4> *p_out, size_t p_count )
+{
+  size_t l_index = 0;
+
+#if defined( __AVX2__ )
+  bool l_reverse = ( p_direction == DIRECTION_DOWN ) || ( p_direction == DIRECTION_RIGHT );
+  bool l_vertical = ( p_direction == DIRECTION_UP ) || ( p_direction == DIRECTION_DOWN );
+
+  for ( ; l_index + BATCH_LANES <= p_count; l_index += BATCH_LANES )
+  {
+    __m256i l_words = _mm256_loadu_si256( (const __m256i *)&p_in[l_index] );
+
+    if ( l_vertical )
+    {
+      l_words = batch_transpose( batch_slide_rows( batch_transpose( l_words ), l_reverse ) );
+    }
+    else
+    {
+      l_words = batch_slide_rows( l_words, l_reverse );
+    }
+
+    _mm256_storeu_si256( (__m256i *)&p_out[l_index], l_words );
+  }
+#endif
+
+  for ( ; l_index < p_count; l_index++ )
+  {
+    p_out[l_index] = p_in[l_index].slide( p_direction );
+  }
+}
+
+
+/* End of file engine/batch.cpp */
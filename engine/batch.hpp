@@ -0,0 +1,55 @@
+/*
+ * engine/batch.hpp; moves applied to whole arrays of boards at once.
+ *
+ * Offline analysis pushes millions of boards through the same move, so it
+ * pays to hand them over in bulk rather than one at a time. The results are
+ * exactly those of Board::slide(); only the throughput differs. The generic
+ * version is just a loop, but the standard 4x4 board gets its own version
+ * in batch.cpp, which on hosts with AVX2 works on four boards at once and
+ * gathers their rows from the tables in a single instruction. Like the
+ * thread pool, batch.cpp is only built for the host.
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+#ifndef _ENGINE_BATCH_HPP_
+#define _ENGINE_BATCH_HPP_
+
+/* System headers. */
+
+#include <cstddef>
+#include <cstdint>
+
+
+/* Local headers. */
+
+#include "board.hpp"
+
+
+/* Functions. */
+
+/*
+ * board_move_batch - slides each of the p_count boards in p_in in the same
+ *                    direction, writing the results to p_out; the two may
+ *                    be the same array.
+ */
+
+template<uint_fast8_t W, uint_fast8_t H, uint_fast8_t B>
+void board_move_batch( direction_t p_direction, const Board<W, H, B> *p_in, Board<W, H, B> *p_out, size_t p_count )
+{
+  for ( size_t l_index = 0; l_index < p_count; l_index++ )
+  {
+    p_out[l_index] = p_in[l_index].slide( p_direction );
+  }
+}
+
+
+/* Functions in batch.cpp. */
+
+template<>
+void board_move_batch<4, 4, 4>( direction_t p_direction, const Board<4, 4> *p_in, Board<4, 4> *p_out, size_t p_count );
+
+#endif /* _ENGINE_BATCH_HPP_ */
+
+/* End of file engine/batch.hpp */
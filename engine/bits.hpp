@@ -0,0 +1,82 @@
+/*
+ * engine/bits.hpp; small bit twiddling helpers used by the board engine.
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+#ifndef _ENGINE_BITS_HPP_
+#define _ENGINE_BITS_HPP_
+
+/* System headers. */
+
+#include <cstdint>
+
+#if defined( __BMI2__ )
+#include <immintrin.h>
+#endif
+
+
+/* Functions. */
+
+/*
+ * bits_count - returns the number of set bits.
+ */
+
+inline uint_fast8_t bits_count( uint64_t p_bits )
+{
+  return __builtin_popcountll( p_bits );
+}
+
+
+/*
+ * bits_first - returns the position of the lowest set bit; there must be
+ *              at least one.
+ */
+
+inline uint_fast8_t bits_first( uint64_t p_bits )
+{
+  return __builtin_ctzll( p_bits );
+}
+
+
+/*
+ * bits_select - returns the position of the nth (counting from 0) set bit,
+ *               starting from the least significant end. p_nth must be less
+ *               than bits_count( p_bits ).
+ */
+
+inline uint_fast8_t bits_select( uint64_t p_bits, uint_fast8_t p_nth )
+{
+#if defined( __BMI2__ )
+  /* Deposit a single bit into the nth set position; one instruction. */
+  return __builtin_ctzll( _pdep_u64( (uint64_t)1 << p_nth, p_bits ) );
+#else
+  uint_fast8_t l_base = 0;
+
+  /* Halve the search three times, to find the byte the bit lives in. */
+  for ( uint_fast8_t l_width = 32; l_width >= 8; l_width /= 2 )
+  {
+    uint_fast8_t l_count = bits_count( p_bits & ( ( (uint64_t)1 << l_width ) - 1 ) );
+
+    if ( p_nth >= l_count )
+    {
+      p_nth -= l_count;
+      p_bits >>= l_width;
+      l_base += l_width;
+    }
+  }
+
+  /* And then step through the (at most eight) bits of that byte. */
+  while( p_nth-- > 0 )
+  {
+    p_bits &= p_bits - 1;
+  }
+
+  return l_base + __builtin_ctzll( p_bits );
+#endif
+}
+
+#endif /* _ENGINE_BITS_HPP_ */
+
+/* End of file engine/bits.hpp */
@@ -0,0 +1,118 @@
+/*
+ * engine/bitslice.cpp; packing boards into and out of bit planes.
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+/* System headers. */
+
+#include <cstdint>
+
+
+/* Local headers. */
+
+#include "bitslice.hpp"
+
+
+/* Functions. */
+
+/*
+ * bitslice_transpose - transposes a 64x64 bit matrix in place, so bit k of
+ *                      word p becomes bit p of word k. Swaps ever smaller
+ *                      blocks across the diagonal; 32x32, then 16x16, and
+ *                      so on down to single bits.
+ */
+
+static void bitslice_transpose( uint64_t *p_words )
+{
+  uint64_t l_mask = 0x00000000FFFFFFFFull;
+
+  for ( uint_fast8_t l_width = 32; l_width != 0; l_width >>= 1, l_mask ^= l_mask << l_width )
+  {
+    for ( uint_fast8_t l_word = 0; l_word < 64; l_word = ( ( l_word | l_width ) + 1 ) & ~l_width )
+    {
+      uint64_t l_swap = ( ( p_words[l_word] >> l_width ) ^ p_words[l_word | l_width] ) & l_mask;
+
+      p_words[l_word] ^= l_swap << l_width;
+      p_words[l_word | l_width] ^= l_swap;
+    }
+  }
+}
+
+
+/*
+ * bitslice_pack - slices 64 boards into a set of planes.
+ */
+
+void bitslice_pack( const bitslice_board_t *p_boards, bitslice_t *p_slice )
+{
+  for ( uint_fast8_t l_board = 0; l_board < BITSLICE_BOARDS; l_board++ )
+  {
+    p_slice->plane[l_board] = p_boards[l_board].m_words[0];
+  }
+  bitslice_transpose( p_slice->plane );
+}
+
+
+/*
+ * bitslice_unpack - turns a set of planes back into 64 boards.
+ */
+
+void bitslice_unpack( const bitslice_t *p_slice, bitslice_board_t *p_boards )
+{
+  uint64_t l_words[BITSLICE_PLANES];
+
+  for ( uint_fast8_t l_plane = 0; l_plane < BITSLICE_PLANES; l_plane++ )
+  {
+    l_words[l_plane] = p_slice->plane[l_plane];
+  }
+  bitslice_transpose( l_words );
+
+  for ( uint_fast8_t l_board = 0; l_board < BITSLICE_BOARDS; l_board++ )
+  {
+    p_boards[l_board].m_words[0] = l_words[l_board];
+  }
+}
+
+
+/*
+ * bitslice_pack_wide - slices 256 boards into a set of wide planes, as four
+ *                      sets of 64 side by side.
+ */
+
+void bitslice_pack_wide( const bitslice_board_t *p_boards, bitslice_wide_t *p_slice )
+{
+  bitslice_t l_slice;
+
+  for ( uint_fast8_t l_lane = 0; l_lane < BITSLICE_LANES; l_lane++ )
+  {
+    bitslice_pack( &p_boards[l_lane * BITSLICE_BOARDS], &l_slice );
+    for ( uint_fast8_t l_plane = 0; l_plane < BITSLICE_PLANES; l_plane++ )
+    {
+      p_slice->plane[l_plane][l_lane] = l_slice.plane[l_plane];
+    }
+  }
+}
+
+
+/*
+ * bitslice_unpack_wide - turns a set of wide planes back into 256 boards.
+ */
+
+void bitslice_unpack_wide( const bitslice_wide_t *p_slice, bitslice_board_t *p_boards )
+{
+  bitslice_t l_slice;
+
+  for ( uint_fast8_t l_lane = 0; l_lane < BITSLICE_LANES; l_lane++ )
+  {
+    for ( uint_fast8_t l_plane = 0; l_plane < BITSLICE_PLANES; l_plane++ )
+    {
+      l_slice.plane[l_plane] = p_slice->plane[l_plane][l_lane];
+    }
+    bitslice_unpack( &l_slice, &p_boards[l_lane * BITSLICE_BOARDS] );
+  }
+}
+
+
+/* End of file engine/bitslice.cpp */
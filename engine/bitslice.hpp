@@ -0,0 +1,177 @@
+/*
+ * engine/bitslice.hpp; moves on many 4x4 boards at once, with no tables.
+ *
+ * A bitsliced set of boards turns the usual layout on its side; instead of
+ * a 64-bit word per board, it has a word per bit of the board (64 of them,
+ * four for each of the 16 cells), with bit k of every word belonging to
+ * board k. Packing 64 boards in and out is a 64x64 bit matrix transpose,
+ * which costs far more than a move; boards are meant to be packed once and
+ * then kept sliced while move after move is made on them.
+ *
+ * Once sliced, a move works on every board at once with nothing but ands,
+ * ors and xors, and so touches no memory beyond the planes themselves: the
+ * tiles in each line are squeezed towards the leading edge by a small
+ * network of conditional pulls, then the first equal pair (if any) in each
+ * line collapses, and one last pull closes the gap it leaves. That is the
+ * same single-collapse rule as board_row_slide(), with the same results.
+ *
+ * The planes can be plain 64-bit words, or any vector type that supports
+ * the bitwise operators; bitslice_wide_t uses 256-bit vectors (AVX2 where
+ * the host has it, split up by the compiler where not) for 256 boards.
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+#ifndef _ENGINE_BITSLICE_HPP_
+#define _ENGINE_BITSLICE_HPP_
+
+/* System headers. */
+
+#include <cstdint>
+
+
+/* Local headers. */
+
+#include "board.hpp"
+
+
+/* Constants. */
+
+#define BITSLICE_SIDE     4
+#define BITSLICE_PLANES   64
+#define BITSLICE_BOARDS   64
+#define BITSLICE_LANES    4
+
+
+/* Local structures and types. */
+
+typedef Board<BITSLICE_SIDE, BITSLICE_SIDE> bitslice_board_t;
+
+/* 64 boards, one per bit of each plane. */
+typedef struct
+{
+  uint64_t  plane[BITSLICE_PLANES];
+} bitslice_t;
+
+/* 256 boards; lane n of each plane holds boards 64n to 64n+63. */
+typedef uint64_t bitslice_lane_t __attribute__(( vector_size( BITSLICE_LANES * sizeof( uint64_t ) ) ));
+
+typedef struct
+{
+  bitslice_lane_t plane[BITSLICE_PLANES];
+} bitslice_wide_t;
+
+
+/* Functions. */
+
+/*
+ * bitslice_pull - on every board where p_to is empty, moves the tile from
+ *                 p_from into it.
+ */
+
+template<typename P>
+inline void bitslice_pull( P *p_to, P *p_from )
+{
+  P l_empty = ~( p_to[0] | p_to[1] | p_to[2] | p_to[3] );
+
+  for ( uint_fast8_t l_bit = 0; l_bit < BOARD_CELL_BITS; l_bit++ )
+  {
+    p_to[l_bit] |= p_from[l_bit] & l_empty;
+    p_from[l_bit] &= ~l_empty;
+  }
+}
+
+
+/*
+ * bitslice_line - slides one line of cells towards its first cell, on
+ *                 every board at once.
+ */
+
+template<typename P>
+inline void bitslice_line( P *p_cells[BITSLICE_SIDE] )
+{
+  P l_done = {};
+
+  /* Squeeze out the gaps; a tile can need to travel the whole line. */
+  for ( uint_fast8_t l_pass = 1; l_pass < BITSLICE_SIDE; l_pass++ )
+  {
+    for ( uint_fast8_t l_cell = 0; l_cell < BITSLICE_SIDE - 1; l_cell++ )
+    {
+      bitslice_pull( p_cells[l_cell], p_cells[l_cell+1] );
+    }
+  }
+
+  /* Collapse the first equal pair; never empties, and never two 15s. */
+  for ( uint_fast8_t l_cell = 0; l_cell < BITSLICE_SIDE - 1; l_cell++ )
+  {
+    P *l_lead = p_cells[l_cell], *l_next = p_cells[l_cell+1];
+    P  l_equal = ( l_lead[0] | l_lead[1] | l_lead[2] | l_lead[3] ) & ~l_done;
+    P  l_carry;
+
+    for ( uint_fast8_t l_bit = 0; l_bit < BOARD_CELL_BITS; l_bit++ )
+    {
+      l_equal &= ~( l_lead[l_bit] ^ l_next[l_bit] );
+    }
+    l_equal &= ~( l_lead[0] & l_lead[1] & l_lead[2] & l_lead[3] );
+    l_done |= l_equal;
+
+    /* The lead tile goes up by one, and the next one disappears. */
+    l_carry = l_equal;
+    for ( uint_fast8_t l_bit = 0; l_bit < BOARD_CELL_BITS; l_bit++ )
+    {
+      P l_overflow = l_lead[l_bit] & l_carry;
+
+      l_lead[l_bit] ^= l_carry;
+      l_next[l_bit] &= ~l_equal;
+      l_carry = l_overflow;
+    }
+  }
+
+  /* One more pass closes the (single) gap a collapse leaves. */
+  for ( uint_fast8_t l_cell = 0; l_cell < BITSLICE_SIDE - 1; l_cell++ )
+  {
+    bitslice_pull( p_cells[l_cell], p_cells[l_cell+1] );
+  }
+}
+
+
+/*
+ * bitslice_move - slides every board in a set of planes in the requested
+ *                 direction.
+ */
+
+template<typename P>
+inline void bitslice_move( P *p_planes, direction_t p_direction )
+{
+  bool l_vertical = ( p_direction == DIRECTION_UP ) || ( p_direction == DIRECTION_DOWN );
+  bool l_reverse = ( p_direction == DIRECTION_DOWN ) || ( p_direction == DIRECTION_RIGHT );
+
+  for ( uint_fast8_t l_line = 0; l_line < BITSLICE_SIDE; l_line++ )
+  {
+    P *l_cells[BITSLICE_SIDE];
+
+    /* Gather up the line's cells, starting from the leading edge. */
+    for ( uint_fast8_t l_index = 0; l_index < BITSLICE_SIDE; l_index++ )
+    {
+      uint_fast8_t l_step = l_reverse ? BITSLICE_SIDE - 1 - l_index : l_index;
+      uint_fast8_t l_cell = l_vertical ? ( l_step * BITSLICE_SIDE + l_line ) : ( l_line * BITSLICE_SIDE + l_step );
+
+      l_cells[l_index] = &p_planes[l_cell * BOARD_CELL_BITS];
+    }
+
+    bitslice_line( l_cells );
+  }
+}
+
+
+/* Functions in bitslice.cpp. */
+
+void bitslice_pack( const bitslice_board_t *p_boards, bitslice_t *p_slice );
+void bitslice_unpack( const bitslice_t *p_slice, bitslice_board_t *p_boards );
+void bitslice_pack_wide( const bitslice_board_t *p_boards, bitslice_wide_t *p_slice );
+void bitslice_unpack_wide( const bitslice_wide_t *p_slice, bitslice_board_t *p_boards );
+
+#endif /* _ENGINE_BITSLICE_HPP_ */
+
+/* End of file engine/bitslice.hpp */
@@ -0,0 +1,215 @@
+/*
+ * engine/board.cpp; the compile-time row transition tables, and checks on
+ * them.
+ *
+ * The tables are defined here and nowhere else, so the compiler builds them
+ * once rather than in every file which includes board.hpp. The definitions
+ * are constexpr; if the compiler can't build one at compile time, that is
+ * an error, rather than a quiet fall back to filling it in at start-up (in
+ * SRAM, on the PicoSystem).
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+/* System headers. */
+
+#include <cstdint>
+
+
+/* Local headers. */
+
+#include "board.hpp"
+
+
+/* Globals. */
+
+template<uint_fast8_t W, uint_fast8_t B>
+constexpr row_table_t<W, B> row_tables_t<W, B>::left = board_build_row_table<W, B>( false );
+
+template<uint_fast8_t W, uint_fast8_t B>
+constexpr row_table_t<W, B> row_tables_t<W, B>::right = board_build_row_table<W, B>( true );
+
+template<uint_fast8_t W, uint_fast8_t B>
+constexpr row_flags_t<W, B> row_tables_t<W, B>::legal = board_build_legal_table<W, B>( row_tables_t<W, B>::left,
+                                                                                        row_tables_t<W, B>::right );
+
+template<uint_fast8_t W, uint_fast8_t B>
+constexpr row_info_t<W, B> row_tables_t<W, B>::info_left = board_build_info_table<W, B>( false );
+
+template<uint_fast8_t W, uint_fast8_t B>
+constexpr row_info_t<W, B> row_tables_t<W, B>::info_right = board_build_info_table<W, B>( true );
+
+template<uint_fast8_t W, uint_fast8_t B>
+constexpr row_table_t<W, B> row_tables_t<W, B>::travel_left = board_build_travel_table<W, B>( false );
+
+template<uint_fast8_t W, uint_fast8_t B>
+constexpr row_table_t<W, B> row_tables_t<W, B>::travel_right = board_build_travel_table<W, B>( true );
+
+template struct row_tables_t<2, 4>;
+template struct row_tables_t<3, 4>;
+template struct row_tables_t<4, 4>;
+template struct row_tables_t<2, 5>;
+template struct row_tables_t<3, 5>;
+
+
+/* Functions. */
+
+/*
+ * board_row_reference - slides a row the slow way, a cell at a time, in the
+ *                       same manner the original board_move() shuffled its
+ *                       work rows. Used only to check the generated tables.
+ *                       p_reverse slides towards the last column instead,
+ *                       and p_merged is set to the exponent of any collapse.
+ *                       Cells are p_bits wide.
+ */
+
+static row_t board_row_reference( row_t p_row, uint_fast8_t p_width, uint_fast8_t p_bits, bool p_reverse,
+                                  uint_fast8_t *p_merged )
+{
+  uint_fast8_t  l_workrow[BOARD_TABLE_BITS / BOARD_CELL_BITS];
+  bool          l_collapsed = false;
+  row_t         l_result = 0;
+
+  *p_merged = 0;
+
+  /* Unpack the row, in the order we want to slide it. */
+  for ( uint_fast8_t l_index = 0; l_index < p_width; l_index++ )
+  {
+    uint_fast8_t l_col = p_reverse ? p_width - 1 - l_index : l_index;
+    l_workrow[l_index] = ( p_row >> ( l_col * p_bits ) ) & BOARD_EXP_MASK( p_bits );
+  }
+
+  /* Shuffle each tile along as far as it will go. */
+  for ( int_fast8_t l_col = 1; l_col < p_width; l_col++ )
+  {
+    int_fast8_t l_altcol = l_col;
+
+    /* Skip empty cells. */
+    if ( l_workrow[l_col] == 0 )
+    {
+      continue;
+    }
+
+    /* Slide into any empty space. */
+    while( ( l_altcol > 0 ) && ( l_workrow[l_altcol-1] == 0 ) )
+    {
+      l_workrow[l_altcol-1] = l_workrow[l_altcol];
+      l_workrow[l_altcol] = 0;
+      l_altcol--;
+    }
+
+    /* And collapse into the next tile, if allowed. */
+    if ( !l_collapsed && ( l_altcol > 0 ) && ( l_workrow[l_altcol-1] == l_workrow[l_altcol] ) &&
+         ( l_workrow[l_altcol] < BOARD_EXP_MASK( p_bits ) ) )
+    {
+      *p_merged = ++l_workrow[l_altcol-1];
+      l_workrow[l_altcol] = 0;
+      l_collapsed = true;
+    }
+  }
+
+  /* Pack it back up again. */
+  for ( uint_fast8_t l_index = 0; l_index < p_width; l_index++ )
+  {
+    uint_fast8_t l_col = p_reverse ? p_width - 1 - l_index : l_index;
+    l_result |= l_workrow[l_index] << ( l_col * p_bits );
+  }
+
+  return l_result;
+}
+
+
+/*
+ * board_row_replay - rebuilds a slid row by moving each tile as far as the
+ *                    travel says, bumping it up if it merged; if the travel
+ *                    tables are right, this matches the slide tables.
+ */
+
+static row_t board_row_replay( row_t p_row, row_t p_travel, uint_fast8_t p_width, uint_fast8_t p_bits, bool p_reverse )
+{
+  row_t l_result = 0;
+
+  /* Walk from the leading edge, so a merge lands on a tile already placed. */
+  for ( uint_fast8_t l_index = 0; l_index < p_width; l_index++ )
+  {
+    uint_fast8_t l_col = p_reverse ? p_width - 1 - l_index : l_index;
+    uint_fast8_t l_cell = ( p_row >> ( l_col * p_bits ) ) & BOARD_EXP_MASK( p_bits );
+    uint_fast8_t l_travel = ROW_TRAVEL( p_travel, l_col );
+    uint_fast8_t l_distance = l_travel & ROW_TRAVEL_DISTANCE_MASK;
+    uint_fast8_t l_end = p_reverse ? l_col + l_distance : l_col - l_distance;
+
+    if ( l_cell == 0 )
+    {
+      continue;
+    }
+
+    /* A merging tile replaces the one it lands on. */
+    if ( l_travel & ROW_TRAVEL_MERGED )
+    {
+      l_result &= ~( (row_t)BOARD_EXP_MASK( p_bits ) << ( l_end * p_bits ) );
+      l_cell++;
+    }
+    l_result |= (row_t)l_cell << ( l_end * p_bits );
+  }
+
+  return l_result;
+}
+
+
+/*
+ * board_verify_row_tables - compares every entry in the compile-time tables
+ *                           for one row width with the reference shuffle,
+ *                           including the merge and max in the info tables,
+ *                           and checks the travel tables replay to the same.
+ */
+
+template<uint_fast8_t W, uint_fast8_t B>
+static bool board_verify_row_tables( void )
+{
+  row_t         l_left, l_right;
+  uint_fast8_t  l_left_merged, l_right_merged;
+
+  for ( row_t l_row = 0; l_row < row_tables_t<W, B>::left.size(); l_row++ )
+  {
+    l_left = board_row_reference( l_row, W, B, false, &l_left_merged );
+    l_right = board_row_reference( l_row, W, B, true, &l_right_merged );
+
+    if ( ( row_tables_t<W, B>::left[l_row] != l_left ) || ( row_tables_t<W, B>::right[l_row] != l_right ) )
+    {
+      return false;
+    }
+
+    if ( ( row_tables_t<W, B>::info_left[l_row] != ROW_INFO( l_left_merged, ( board_row_max<W, B>( l_left ) ), B ) ) ||
+         ( row_tables_t<W, B>::info_right[l_row] != ROW_INFO( l_right_merged, ( board_row_max<W, B>( l_right ) ), B ) ) )
+    {
+      return false;
+    }
+
+    if ( ( board_row_replay( l_row, row_tables_t<W, B>::travel_left[l_row], W, B, false ) != l_left ) ||
+         ( board_row_replay( l_row, row_tables_t<W, B>::travel_right[l_row], W, B, true ) != l_right ) )
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+/*
+ * board_verify_tables - compares every entry in the compile-time tables with
+ *                       a result computed at runtime by the reference
+ *                       shuffle; returns true if they are bit-identical.
+ *                       Covers every row width, and cell size, that gets
+ *                       tables.
+ */
+
+bool board_verify_tables( void )
+{
+  return board_verify_row_tables<2, 4>() && board_verify_row_tables<3, 4>() && board_verify_row_tables<4, 4>() &&
+         board_verify_row_tables<2, 5>() && board_verify_row_tables<3, 5>();
+}
+
+
+/* End of file engine/board.cpp */
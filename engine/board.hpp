@@ -0,0 +1,1301 @@
+/*
+ * engine/board.hpp; the packed board representation for 2040-eight.
+ *
+ * A board is a Board<W,H> template, with every cell a 4-bit nibble holding
+ * the tile's exponent (so 1 is a '2', 2 is a '4' and so on, with 0 meaning
+ * an empty cell). Cells are packed row by row, with each row a contiguous
+ * run of nibbles that never straddles a storage word; the storage itself is
+ * the tightest that fits the board, so a 4x4 board is a single 64-bit value
+ * (each row in its own 16 bits), a 3x3 one also fits in 64 bits, while 5x5
+ * and 6x6 boards are split over two and three 64-bit words.
+ *
+ * Nibbles top out at a 32768 tile, which the game never sees but long AI
+ * runs can; Board<W,H,5> gives every cell 5 bits instead, for tiles of up
+ * to 2^31. That costs a wider board (a 4x4 one then needs two words), and
+ * rows of more than three cells are then too wide to have tables of their
+ * own. Those borrow the 4-bit tables while every tile in them is below
+ * 32768, so only rows holding bigger tiles run the slide kernel.
+ *
+ * Moves work a row at a time. For rows of up to 16 bits, every possible row
+ * has its slid result precomputed for both LEFT and RIGHT; the tables are
+ * generated by the compiler, once, in board.cpp, and end up as const data
+ * in flash, so they cost neither SRAM nor start-up time on the PicoSystem.
+ * Wider rows, where the tables would be far too large, run the same slide
+ * kernel directly. Square single-word boards transpose so that UP and DOWN
+ * can use the row tables too (the 4x4 one with a handful of shifts and
+ * masks, so UP and DOWN cost no more than LEFT and RIGHT); anything else
+ * slides its columns one at a time.
+ *
+ * Which directions are legal at all comes from a third table, of flags for
+ * whether LEFT and RIGHT change each row; a board's legal_moves() is then
+ * one lookup per row and one per column.
+ *
+ * Every move also reports the score it earned (the face value of whatever
+ * it merged) and the highest exponent left on the board; those come from a
+ * pair of info tables alongside the slide tables, holding for every row the
+ * exponent of its merge (if any) and of its largest tile once moved, so no
+ * one ever has to go back over the board to find them.
+ *
+ * The travel tables say, for every row, how far each tile in it slides and
+ * whether it merges on arrival; the game builds its animations from these,
+ * so what's drawn always matches the move that was actually made.
+ *
+ * Boards can be reflected and rotated, and canonical() picks the smallest
+ * of the (up to eight) forms, so that symmetric positions can share one
+ * entry in a table; the 4x4 board does all of this with shifts and masks.
+ *
+ * Every board has a Zobrist hash; the xor of a constant random key for
+ * each cell's exponent. Rather than being worked out afresh for every new
+ * board, it can be updated cell by cell as tiles change (or, for a whole
+ * move, from the cells which differ) at the cost of an xor or two each.
+ *
+ * Empty cells are tracked as a cellmask_t, with bit ( row * W ) + col set
+ * for each empty cell; move() hands back the mask for the new board, so the
+ * caller can keep it up to date and pick spawn cells with a popcount and a
+ * select instead of scanning the board. A spawn's cell and value (a '4'
+ * BOARD_SPAWN_FOUR_PERCENT of the time, otherwise a '2') both come out of a
+ * single 32-bit random draw.
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+#ifndef _ENGINE_BOARD_HPP_
+#define _ENGINE_BOARD_HPP_
+
+/* System headers. */
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+
+/* Local headers. */
+
+#include "bits.hpp"
+#include "rng.hpp"
+
+
+/* Constants. */
+
+#define BOARD_CELL_BITS   4
+#define BOARD_CELL_MASK   0xF
+#define BOARD_MAX_EXP     15
+#define BOARD_TABLE_BITS  16
+
+/* The mask (and largest exponent) for cells of a given number of bits. */
+#define BOARD_EXP_MASK( b ) ( ( 1u << (b) ) - 1 )
+
+/* How often a spawned tile is a '4' rather than a '2'; override at build. */
+#ifndef BOARD_SPAWN_FOUR_PERCENT
+#define BOARD_SPAWN_FOUR_PERCENT  10
+#endif
+#define BOARD_SPAWN_FOUR_LIMIT    ( ( 0x100000000ull * BOARD_SPAWN_FOUR_PERCENT ) / 100 )
+
+/* The Zobrist keys cover every cell and exponent any board can have. */
+#define BOARD_KEY_CELLS   64
+#define BOARD_KEY_EXPS    32
+#define BOARD_KEY_SEED    0x2040E16472ull
+
+
+/* Local structures and types. */
+
+typedef enum
+{
+  DIRECTION_UP,
+  DIRECTION_DOWN,
+  DIRECTION_LEFT,
+  DIRECTION_RIGHT,
+  DIRECTION_COUNT
+} direction_t;
+
+/* Legal directions are reported as a mask of these bits. */
+#define DIRECTION_BIT( d )  ( 1u << ( d ) )
+
+/* The symmetries of a board are combinations of these, so there are */
+/* eight for a square board and four for any other.                  */
+#define BOARD_SYMMETRY_MIRROR     0x01
+#define BOARD_SYMMETRY_FLIP       0x02
+#define BOARD_SYMMETRY_TRANSPOSE  0x04
+#define BOARD_SYMMETRIES          8
+
+/* Flags in the row legality table. */
+#define ROW_LEGAL_LEFT      0x01
+#define ROW_LEGAL_RIGHT     0x02
+
+/* Entries in the row info tables; the merged and maximum exponents, */
+/* each taking as many bits as a cell.                               */
+#define ROW_INFO( m, x, b )       ( ( (x) << (b) ) | (m) )
+#define ROW_INFO_MERGED( i, b )   ( (i) & BOARD_EXP_MASK( b ) )
+#define ROW_INFO_MAX( i, b )      ( (i) >> (b) )
+
+/* Entries in the row travel tables; a nibble per cell, in cell order, */
+/* holding how far its tile slides and whether it merges.              */
+#define ROW_TRAVEL_BITS           4
+#define ROW_TRAVEL( t, c )        ( ( (t) >> ( (c) * ROW_TRAVEL_BITS ) ) & 0xF )
+#define ROW_TRAVEL_DISTANCE_MASK  0x07
+#define ROW_TRAVEL_MERGED         0x08
+
+/* A single row (or column) of cells, packed the same way as on the board. */
+typedef uint32_t row_t;
+
+template<uint_fast8_t W, uint_fast8_t B = BOARD_CELL_BITS>
+using row_table_t = std::array<uint16_t, ( 1u << ( W * B ) )>;
+
+template<uint_fast8_t W, uint_fast8_t B = BOARD_CELL_BITS>
+using row_flags_t = std::array<uint8_t, ( 1u << ( W * B ) )>;
+
+template<uint_fast8_t W, uint_fast8_t B = BOARD_CELL_BITS>
+using row_info_t = std::array<typename std::conditional<( B * 2 ) <= 8, uint8_t, uint16_t>::type, ( 1u << ( W * B ) )>;
+
+/* One bit per cell, set where the cell is empty. */
+typedef uint64_t cellmask_t;
+
+/* A random key for every exponent in every cell. */
+typedef std::array<std::array<uint64_t, BOARD_KEY_EXPS>, BOARD_KEY_CELLS> board_keys_t;
+
+/* Where a new tile goes, and what it is. */
+typedef struct
+{
+  uint_fast8_t  cell;
+  uint_fast8_t  exponent;
+} spawn_pick_t;
+
+/* What a move hands back; the board, its empty cells, the score earned */
+/* and the largest exponent now on the board.                           */
+template<typename B>
+struct move_result_t
+{
+  B             board;
+  cellmask_t    empty;
+  uint64_t      score;
+  uint_fast8_t  max_exponent;
+};
+
+
+/* Functions. */
+
+/*
+ * board_cell_value - converts a cell exponent into the face value of the
+ *                    tile, for display purposes.
+ */
+
+inline uint32_t board_cell_value( uint_fast8_t p_exponent )
+{
+  return ( p_exponent == 0 ) ? 0 : ( 1u << p_exponent );
+}
+
+
+/*
+ * board_build_keys - generates the Zobrist keys; a fresh splitmix64 value
+ *                    for each exponent in each cell, except that an empty
+ *                    cell is always 0 so an empty board hashes to 0.
+ */
+
+constexpr board_keys_t board_build_keys( void )
+{
+  board_keys_t  l_keys = {};
+  uint64_t      l_seed = BOARD_KEY_SEED;
+
+  for ( uint_fast8_t l_cell = 0; l_cell < BOARD_KEY_CELLS; l_cell++ )
+  {
+    for ( uint_fast8_t l_exponent = 1; l_exponent < BOARD_KEY_EXPS; l_exponent++ )
+    {
+      l_keys[l_cell][l_exponent] = rng_splitmix( &l_seed );
+    }
+  }
+
+  return l_keys;
+}
+
+inline constexpr board_keys_t g_board_keys = board_build_keys();
+
+
+/*
+ * board_hash_cell - updates a hash for one cell changing its exponent.
+ */
+
+inline uint64_t board_hash_cell( uint64_t p_hash, uint_fast8_t p_cell, uint_fast8_t p_from, uint_fast8_t p_to )
+{
+  return p_hash ^ g_board_keys[p_cell][p_from] ^ g_board_keys[p_cell][p_to];
+}
+
+
+/*
+ * board_row_slide - slides a single row of W cells towards cell 0 (or cell
+ *                   W-1, if reversed), returning the result. Only one collapse
+ *                   is allowed per row, exactly as the original cell-by-cell
+ *                   shuffle behaved.
+ */
+
+template<uint_fast8_t W, uint_fast8_t B = BOARD_CELL_BITS>
+constexpr row_t board_row_slide( row_t p_row, bool p_reverse )
+{
+  uint_fast8_t  l_cells[W] = { 0 };
+  uint_fast8_t  l_count = 0;
+  bool          l_collapsed = false;
+  row_t         l_result = 0;
+
+  /* Walk the row from the leading edge, stacking up the tiles we find. */
+  for ( uint_fast8_t l_index = 0; l_index < W; l_index++ )
+  {
+    uint_fast8_t l_col = p_reverse ? W - 1 - l_index : l_index;
+    uint_fast8_t l_cell = ( p_row >> ( l_col * B ) ) & BOARD_EXP_MASK( B );
+
+    /* Empty cells just get squeezed out. */
+    if ( l_cell == 0 )
+    {
+      continue;
+    }
+
+    /* Collapse into the previous tile if we can, otherwise stack it. */
+    if ( !l_collapsed && ( l_count > 0 ) && ( l_cells[l_count-1] == l_cell ) && ( l_cell < BOARD_EXP_MASK( B ) ) )
+    {
+      l_cells[l_count-1]++;
+      l_collapsed = true;
+    }
+    else
+    {
+      l_cells[l_count++] = l_cell;
+    }
+  }
+
+  /* Pack the stacked tiles back into a row, from the same edge. */
+  for ( uint_fast8_t l_index = 0; l_index < l_count; l_index++ )
+  {
+    uint_fast8_t l_col = p_reverse ? W - 1 - l_index : l_index;
+    l_result |= (row_t)l_cells[l_index] << ( l_col * B );
+  }
+
+  return l_result;
+}
+
+
+/*
+ * board_row_merged - returns the exponent of the tile that sliding a row
+ *                    would create by collapsing, or 0 if nothing would. The
+ *                    collapse is always between the first pair of equal
+ *                    tiles (gaps aside) counting from the leading edge, so
+ *                    this is a much cheaper scan than the slide itself.
+ */
+
+template<uint_fast8_t W, uint_fast8_t B = BOARD_CELL_BITS>
+constexpr uint_fast8_t board_row_merged( row_t p_row, bool p_reverse )
+{
+  uint_fast8_t l_previous = 0;
+
+  for ( uint_fast8_t l_index = 0; l_index < W; l_index++ )
+  {
+    uint_fast8_t l_col = p_reverse ? W - 1 - l_index : l_index;
+    uint_fast8_t l_cell = ( p_row >> ( l_col * B ) ) & BOARD_EXP_MASK( B );
+
+    if ( l_cell == 0 )
+    {
+      continue;
+    }
+    if ( ( l_cell == l_previous ) && ( l_cell < BOARD_EXP_MASK( B ) ) )
+    {
+      return l_cell + 1;
+    }
+    l_previous = l_cell;
+  }
+
+  return 0;
+}
+
+
+/*
+ * board_row_max - returns the largest exponent in a row of W cells.
+ */
+
+template<uint_fast8_t W, uint_fast8_t B = BOARD_CELL_BITS>
+constexpr uint_fast8_t board_row_max( row_t p_row )
+{
+  uint_fast8_t l_max = 0;
+
+  for ( uint_fast8_t l_col = 0; l_col < W; l_col++ )
+  {
+    uint_fast8_t l_cell = ( p_row >> ( l_col * B ) ) & BOARD_EXP_MASK( B );
+    if ( l_cell > l_max )
+    {
+      l_max = l_cell;
+    }
+  }
+
+  return l_max;
+}
+
+
+/*
+ * board_spawn_pick - chooses a cell (by index, row * W + col) from the empty
+ *                    ones in p_empty, and whether it gets a '2' or a '4',
+ *                    from one draw of the generator. The draw is scaled by
+ *                    the number of empty cells; the top half of the product
+ *                    picks the cell, and the bottom half is still uniform
+ *                    and independent of it, so it decides the value. There
+ *                    must be at least one empty cell.
+ */
+
+inline spawn_pick_t board_spawn_pick( cellmask_t p_empty, rng_t *p_rng )
+{
+  spawn_pick_t  l_pick;
+  uint64_t      l_scaled = (uint64_t)rng_next( p_rng ) * bits_count( p_empty );
+
+  l_pick.cell = bits_select( p_empty, l_scaled >> 32 );
+  l_pick.exponent = 1 + ( (uint32_t)l_scaled < BOARD_SPAWN_FOUR_LIMIT );
+
+  return l_pick;
+}
+
+
+/*
+ * board_row_empty - returns a W-bit mask of the empty cells in a row.
+ */
+
+template<uint_fast8_t W, uint_fast8_t B = BOARD_CELL_BITS>
+inline row_t board_row_empty( row_t p_row )
+{
+  row_t l_zeros = p_row, l_result = 0;
+
+  /* Fold each cell down onto its lowest bit, which is clear if it's empty. */
+  for ( uint_fast8_t l_bit = 1; l_bit < B; l_bit++ )
+  {
+    l_zeros |= p_row >> l_bit;
+  }
+  l_zeros = ~l_zeros;
+
+  /* And gather those bits together. */
+  for ( uint_fast8_t l_col = 0; l_col < W; l_col++ )
+  {
+    l_result |= ( ( l_zeros >> ( l_col * B ) ) & 1 ) << l_col;
+  }
+
+  return l_result;
+}
+
+
+/*
+ * board_build_row_table - generates the slide result for every possible row.
+ */
+
+template<uint_fast8_t W, uint_fast8_t B = BOARD_CELL_BITS>
+constexpr row_table_t<W, B> board_build_row_table( bool p_reverse )
+{
+  row_table_t<W, B> l_table = {};
+
+  for ( row_t l_row = 0; l_row < l_table.size(); l_row++ )
+  {
+    l_table[l_row] = board_row_slide<W, B>( l_row, p_reverse );
+  }
+
+  return l_table;
+}
+
+
+/* Only rows which fit in BOARD_TABLE_BITS get tables. */
+
+template<uint_fast8_t W, uint_fast8_t B = BOARD_CELL_BITS>
+inline constexpr bool g_row_tabled = ( W * B ) <= BOARD_TABLE_BITS;
+
+
+/* The tables for every row width that has them. They are built by the  */
+/* compiler in board.cpp, and only there; every other file just sees    */
+/* const data, which on the PicoSystem stays in flash.                  */
+
+template<uint_fast8_t W, uint_fast8_t B = BOARD_CELL_BITS>
+struct row_tables_t
+{
+  static const row_table_t<W, B>  left;
+  static const row_table_t<W, B>  right;
+  static const row_flags_t<W, B>  legal;
+  static const row_info_t<W, B>   info_left;
+  static const row_info_t<W, B>   info_right;
+  static const row_table_t<W, B>  travel_left;
+  static const row_table_t<W, B>  travel_right;
+};
+
+extern template struct row_tables_t<2, 4>;
+extern template struct row_tables_t<3, 4>;
+extern template struct row_tables_t<4, 4>;
+extern template struct row_tables_t<2, 5>;
+extern template struct row_tables_t<3, 5>;
+
+
+/* A row too wide for tables of its own can still borrow the 4-bit ones, */
+/* if every tile in it is below the 4-bit cap; then nothing it merges    */
+/* can reach the cap either, and it slides just as the narrower row.     */
+
+template<uint_fast8_t W, uint_fast8_t B = BOARD_CELL_BITS>
+inline constexpr bool g_row_narrowable = !g_row_tabled<W, B> && ( B > BOARD_CELL_BITS ) &&
+                                         g_row_tabled<W, BOARD_CELL_BITS>;
+
+
+/*
+ * board_row_narrow - repacks a row of B-bit cells as 4-bit ones, into
+ *                    p_narrow; returns false (and the row can't be looked
+ *                    up that way) if any tile is too big for the 4-bit
+ *                    tables to slide it the same way.
+ */
+
+template<uint_fast8_t W, uint_fast8_t B>
+inline bool board_row_narrow( row_t p_row, row_t *p_narrow )
+{
+  row_t l_narrow = 0, l_high = 0, l_lows = 0, l_full;
+
+  for ( uint_fast8_t l_col = 0; l_col < W; l_col++ )
+  {
+    row_t l_cell = ( p_row >> ( l_col * B ) ) & BOARD_EXP_MASK( B );
+
+    l_narrow |= ( l_cell & BOARD_CELL_MASK ) << ( l_col * BOARD_CELL_BITS );
+    l_high |= l_cell >> BOARD_CELL_BITS;
+    l_lows |= (row_t)1 << ( l_col * BOARD_CELL_BITS );
+  }
+
+  /* A nibble of all ones is a tile the 4-bit rules never collapse. */
+  l_full = l_narrow & ( l_narrow >> 1 ) & ( l_narrow >> 2 ) & ( l_narrow >> 3 ) & l_lows;
+
+  *p_narrow = l_narrow;
+  return ( l_high == 0 ) && ( l_full == 0 );
+}
+
+
+/*
+ * board_row_widen - repacks a row of 4-bit cells as B-bit ones.
+ */
+
+template<uint_fast8_t W, uint_fast8_t B>
+inline row_t board_row_widen( row_t p_narrow )
+{
+  row_t l_result = 0;
+
+  for ( uint_fast8_t l_col = 0; l_col < W; l_col++ )
+  {
+    l_result |= ( ( p_narrow >> ( l_col * BOARD_CELL_BITS ) ) & BOARD_CELL_MASK ) << ( l_col * B );
+  }
+
+  return l_result;
+}
+
+
+/*
+ * board_build_legal_table - generates the legality flags for every possible
+ *                           row, straight from the slide tables.
+ */
+
+template<uint_fast8_t W, uint_fast8_t B = BOARD_CELL_BITS>
+constexpr row_flags_t<W, B> board_build_legal_table( const row_table_t<W, B> &p_left, const row_table_t<W, B> &p_right )
+{
+  row_flags_t<W, B> l_table = {};
+
+  for ( row_t l_row = 0; l_row < l_table.size(); l_row++ )
+  {
+    l_table[l_row] = ( ( p_left[l_row] != l_row ) ? ROW_LEGAL_LEFT : 0 ) |
+                     ( ( p_right[l_row] != l_row ) ? ROW_LEGAL_RIGHT : 0 );
+  }
+
+  return l_table;
+}
+
+
+/*
+ * board_build_info_table - generates the ROW_INFO() for every possible row;
+ *                          the exponent it merges, and its largest exponent
+ *                          after the slide.
+ */
+
+template<uint_fast8_t W, uint_fast8_t B = BOARD_CELL_BITS>
+constexpr row_info_t<W, B> board_build_info_table( bool p_reverse )
+{
+  row_info_t<W, B> l_table = {};
+
+  for ( row_t l_row = 0; l_row < l_table.size(); l_row++ )
+  {
+    uint_fast8_t l_merged = board_row_merged<W, B>( l_row, p_reverse );
+    uint_fast8_t l_max = board_row_max<W, B>( l_row );
+
+    /* A collapse is the only way a slide can raise the largest tile. */
+    l_table[l_row] = ROW_INFO( l_merged, ( l_merged > l_max ) ? l_merged : l_max, B );
+  }
+
+  return l_table;
+}
+
+
+/*
+ * board_row_move - slides a row towards cell 0, or towards cell W-1 if
+ *                  reversed; a table lookup where we have tables, otherwise
+ *                  the slide kernel itself.
+ */
+
+template<uint_fast8_t W, uint_fast8_t B = BOARD_CELL_BITS>
+inline row_t board_row_move( row_t p_row, bool p_reverse )
+{
+  if constexpr ( g_row_tabled<W, B> )
+  {
+    return p_reverse ? row_tables_t<W, B>::right[p_row] : row_tables_t<W, B>::left[p_row];
+  }
+  else
+  {
+    row_t l_narrow;
+
+    if constexpr ( g_row_narrowable<W, B> )
+    {
+      if ( board_row_narrow<W, B>( p_row, &l_narrow ) )
+      {
+        return board_row_widen<W, B>( board_row_move<W>( l_narrow, p_reverse ) );
+      }
+    }
+    return board_row_slide<W, B>( p_row, p_reverse );
+  }
+}
+
+
+/*
+ * board_row_info - returns the ROW_INFO() for sliding a row towards cell 0,
+ *                  or towards cell W-1 if reversed.
+ */
+
+template<uint_fast8_t W, uint_fast8_t B = BOARD_CELL_BITS>
+inline uint_fast16_t board_row_info( row_t p_row, bool p_reverse )
+{
+  if constexpr ( g_row_tabled<W, B> )
+  {
+    return p_reverse ? row_tables_t<W, B>::info_right[p_row] : row_tables_t<W, B>::info_left[p_row];
+  }
+  else
+  {
+    row_t         l_narrow;
+    uint_fast16_t l_info;
+    uint_fast8_t  l_merged, l_max;
+
+    if constexpr ( g_row_narrowable<W, B> )
+    {
+      if ( board_row_narrow<W, B>( p_row, &l_narrow ) )
+      {
+        l_info = board_row_info<W>( l_narrow, p_reverse );
+        return ROW_INFO( ROW_INFO_MERGED( l_info, BOARD_CELL_BITS ), ROW_INFO_MAX( l_info, BOARD_CELL_BITS ), B );
+      }
+    }
+
+    l_merged = board_row_merged<W, B>( p_row, p_reverse );
+    l_max = board_row_max<W, B>( p_row );
+    return ROW_INFO( l_merged, ( l_merged > l_max ) ? l_merged : l_max, B );
+  }
+}
+
+
+/*
+ * board_row_travel - works out where every tile in a row goes when it is
+ *                    slid; for each cell with a tile, the distance it moves
+ *                    and ROW_TRAVEL_MERGED if it collapses into another,
+ *                    packed into a nibble per cell. Follows exactly the
+ *                    same rules as board_row_slide().
+ */
+
+template<uint_fast8_t W, uint_fast8_t B = BOARD_CELL_BITS>
+constexpr row_t board_row_travel( row_t p_row, bool p_reverse )
+{
+  uint_fast8_t  l_top = 0;
+  uint_fast8_t  l_count = 0;
+  bool          l_collapsed = false;
+  row_t         l_result = 0;
+
+  for ( uint_fast8_t l_index = 0; l_index < W; l_index++ )
+  {
+    uint_fast8_t l_col = p_reverse ? W - 1 - l_index : l_index;
+    uint_fast8_t l_cell = ( p_row >> ( l_col * B ) ) & BOARD_EXP_MASK( B );
+
+    if ( l_cell == 0 )
+    {
+      continue;
+    }
+
+    /* A collapsing tile lands on the last one stacked; others stack up. */
+    if ( !l_collapsed && ( l_count > 0 ) && ( l_top == l_cell ) && ( l_cell < BOARD_EXP_MASK( B ) ) )
+    {
+      l_result |= (row_t)( ROW_TRAVEL_MERGED | ( l_index - l_count + 1 ) ) << ( l_col * ROW_TRAVEL_BITS );
+      l_collapsed = true;
+    }
+    else
+    {
+      l_result |= (row_t)( l_index - l_count ) << ( l_col * ROW_TRAVEL_BITS );
+      l_top = l_cell;
+      l_count++;
+    }
+  }
+
+  return l_result;
+}
+
+
+/*
+ * board_build_travel_table - generates the travels for every possible row.
+ */
+
+template<uint_fast8_t W, uint_fast8_t B = BOARD_CELL_BITS>
+constexpr row_table_t<W, B> board_build_travel_table( bool p_reverse )
+{
+  row_table_t<W, B> l_table = {};
+
+  for ( row_t l_row = 0; l_row < l_table.size(); l_row++ )
+  {
+    l_table[l_row] = board_row_travel<W, B>( l_row, p_reverse );
+  }
+
+  return l_table;
+}
+
+
+/*
+ * board_row_travels - returns the board_row_travel() for sliding a row
+ *                     towards cell 0, or towards cell W-1 if reversed.
+ */
+
+template<uint_fast8_t W, uint_fast8_t B = BOARD_CELL_BITS>
+inline row_t board_row_travels( row_t p_row, bool p_reverse )
+{
+  if constexpr ( g_row_tabled<W, B> )
+  {
+    return p_reverse ? row_tables_t<W, B>::travel_right[p_row] : row_tables_t<W, B>::travel_left[p_row];
+  }
+  else
+  {
+    return board_row_travel<W, B>( p_row, p_reverse );
+  }
+}
+
+
+/*
+ * board_row_legal - returns the ROW_LEGAL_ flags for a row; which of the
+ *                   two directions would change it.
+ */
+
+template<uint_fast8_t W, uint_fast8_t B = BOARD_CELL_BITS>
+inline uint_fast8_t board_row_legal( row_t p_row )
+{
+  if constexpr ( g_row_tabled<W, B> )
+  {
+    return row_tables_t<W, B>::legal[p_row];
+  }
+  else
+  {
+    row_t l_narrow;
+
+    if constexpr ( g_row_narrowable<W, B> )
+    {
+      if ( board_row_narrow<W, B>( p_row, &l_narrow ) )
+      {
+        return board_row_legal<W>( l_narrow );
+      }
+    }
+    return ( ( board_row_slide<W, B>( p_row, false ) != p_row ) ? ROW_LEGAL_LEFT : 0 ) |
+           ( ( board_row_slide<W, B>( p_row, true ) != p_row ) ? ROW_LEGAL_RIGHT : 0 );
+  }
+}
+
+
+/* The board itself. */
+
+template<uint_fast8_t W, uint_fast8_t H, uint_fast8_t B = BOARD_CELL_BITS>
+struct Board
+{
+  /* Geometry, and how it maps onto the storage words. */
+  static constexpr uint_fast8_t width = W;
+  static constexpr uint_fast8_t height = H;
+  static constexpr uint_fast8_t cells = W * H;
+  static constexpr uint_fast8_t cell_bits = B;
+  static constexpr uint_fast8_t cell_mask = BOARD_EXP_MASK( B );
+  static constexpr uint_fast8_t max_exponent = BOARD_EXP_MASK( B );
+  static constexpr uint_fast8_t row_bits = W * B;
+  static constexpr row_t        row_mask = ( (row_t)1 << row_bits ) - 1;
+  static constexpr cellmask_t   all_cells = ( (cellmask_t)1 << cells ) - 1;
+
+  typedef typename std::conditional<( W * H * B ) <= 32, uint32_t, uint64_t>::type word_t;
+
+  static constexpr uint_fast8_t rows_per_word = ( sizeof( word_t ) * 8 ) / row_bits;
+  static constexpr uint_fast8_t words = ( H + rows_per_word - 1 ) / rows_per_word;
+
+  static_assert( W >= 2 && H >= 2, "boards need at least two cells each way" );
+  static_assert( B == 4 || B == 5, "cells hold 4 or 5 bit exponents" );
+  static_assert( row_bits < 32 && ( H * B ) < 32, "rows and columns must fit in a row_t" );
+  static_assert( cells < 64, "every cell needs a bit in a cellmask_t" );
+
+  word_t  m_words[words];
+
+
+  /*
+   * row - returns the packed cells of a single row.
+   */
+
+  row_t row( uint_fast8_t p_row ) const
+  {
+    return ( m_words[p_row / rows_per_word] >> ( ( p_row % rows_per_word ) * row_bits ) ) & row_mask;
+  }
+
+
+  /*
+   * set_row - replaces the cells of a single row.
+   */
+
+  void set_row( uint_fast8_t p_row, row_t p_value )
+  {
+    uint_fast8_t l_shift = ( p_row % rows_per_word ) * row_bits;
+    word_t      &l_word = m_words[p_row / rows_per_word];
+
+    l_word = ( l_word & ~( (word_t)row_mask << l_shift ) ) | ( (word_t)( p_value & row_mask ) << l_shift );
+  }
+
+
+  /*
+   * column - returns the cells of a single column, packed as if it were a
+   *          row with the top cell first.
+   */
+
+  row_t column( uint_fast8_t p_col ) const
+  {
+    row_t l_result = 0;
+
+    for ( uint_fast8_t l_row = 0; l_row < H; l_row++ )
+    {
+      l_result |= (row_t)cell( l_row, p_col ) << ( l_row * B );
+    }
+
+    return l_result;
+  }
+
+
+  /*
+   * set_column - replaces the cells of a single column, packed as a row.
+   */
+
+  void set_column( uint_fast8_t p_col, row_t p_value )
+  {
+    for ( uint_fast8_t l_row = 0; l_row < H; l_row++ )
+    {
+      set_cell( l_row, p_col, ( p_value >> ( l_row * B ) ) & cell_mask );
+    }
+  }
+
+
+  /*
+   * cell - returns the exponent held in a given cell; 0 if empty.
+   */
+
+  uint_fast8_t cell( uint_fast8_t p_row, uint_fast8_t p_col ) const
+  {
+    return ( row( p_row ) >> ( p_col * B ) ) & cell_mask;
+  }
+
+
+  /*
+   * set_cell - sets the given cell to the exponent provided; 0 empties it.
+   */
+
+  void set_cell( uint_fast8_t p_row, uint_fast8_t p_col, uint_fast8_t p_exponent )
+  {
+    uint_fast8_t l_shift = ( p_row % rows_per_word ) * row_bits + ( p_col * B );
+    word_t      &l_word = m_words[p_row / rows_per_word];
+
+    l_word = ( l_word & ~( (word_t)cell_mask << l_shift ) ) | ( (word_t)( p_exponent & cell_mask ) << l_shift );
+  }
+
+
+  /*
+   * transpose - returns the board flipped about its leading diagonal, so
+   *             that columns become rows. Only meaningful for square boards.
+   *             The standard 4x4 board does it in one word, with no loops
+   *             or branches; first swapping the cells in each 2x2 block
+   *             across their diagonals, then the 2x2 blocks themselves.
+   */
+
+  Board transpose( void ) const
+  {
+    static_assert( W == H, "only square boards can be transposed" );
+    Board l_result = {};
+
+    if constexpr ( ( W == 4 ) && ( B == 4 ) && ( words == 1 ) )
+    {
+      uint64_t l_word = m_words[0];
+
+      l_word = ( l_word & 0xF0F00F0FF0F00F0Full ) |
+               ( ( l_word & 0x0000F0F00000F0F0ull ) << 12 ) |
+               ( ( l_word & 0x0F0F00000F0F0000ull ) >> 12 );
+      l_word = ( l_word & 0xFF00FF0000FF00FFull ) |
+               ( ( l_word & 0x00000000FF00FF00ull ) << 24 ) |
+               ( ( l_word & 0x00FF00FF00000000ull ) >> 24 );
+
+      l_result.m_words[0] = l_word;
+    }
+    else
+    {
+      for ( uint_fast8_t l_col = 0; l_col < W; l_col++ )
+      {
+        l_result.set_row( l_col, column( l_col ) );
+      }
+    }
+
+    return l_result;
+  }
+
+
+  /*
+   * mirror - returns the board reflected left to right, so each row runs
+   *          backwards. The 4x4 board swaps bytes and then nibbles within
+   *          each row in one go.
+   */
+
+  Board mirror( void ) const
+  {
+    Board l_result = {};
+
+    if constexpr ( ( W == 4 ) && ( B == 4 ) && ( words == 1 ) )
+    {
+      uint64_t l_word = m_words[0];
+
+      l_word = ( ( l_word & 0xFF00FF00FF00FF00ull ) >> 8 ) | ( ( l_word & 0x00FF00FF00FF00FFull ) << 8 );
+      l_word = ( ( l_word & 0xF0F0F0F0F0F0F0F0ull ) >> 4 ) | ( ( l_word & 0x0F0F0F0F0F0F0F0Full ) << 4 );
+
+      l_result.m_words[0] = l_word;
+    }
+    else
+    {
+      for ( uint_fast8_t l_row = 0; l_row < H; l_row++ )
+      {
+        for ( uint_fast8_t l_col = 0; l_col < W; l_col++ )
+        {
+          l_result.set_cell( l_row, W - 1 - l_col, cell( l_row, l_col ) );
+        }
+      }
+    }
+
+    return l_result;
+  }
+
+
+  /*
+   * flip - returns the board reflected top to bottom, so the rows are in
+   *        reverse order. The 4x4 board swaps its halves, then the rows in
+   *        each half.
+   */
+
+  Board flip( void ) const
+  {
+    Board l_result = {};
+
+    if constexpr ( ( W == 4 ) && ( H == 4 ) && ( B == 4 ) && ( words == 1 ) )
+    {
+      uint64_t l_word = m_words[0];
+
+      l_word = ( l_word >> 32 ) | ( l_word << 32 );
+      l_word = ( ( l_word & 0xFFFF0000FFFF0000ull ) >> 16 ) | ( ( l_word & 0x0000FFFF0000FFFFull ) << 16 );
+
+      l_result.m_words[0] = l_word;
+    }
+    else
+    {
+      for ( uint_fast8_t l_row = 0; l_row < H; l_row++ )
+      {
+        l_result.set_row( H - 1 - l_row, row( l_row ) );
+      }
+    }
+
+    return l_result;
+  }
+
+
+  /*
+   * transform - returns the board under one of its symmetries; a mix of
+   *             BOARD_SYMMETRY_ flags, applied mirror first, then flip and
+   *             lastly transpose (which only square boards have).
+   */
+
+  Board transform( uint_fast8_t p_symmetry ) const
+  {
+    Board l_result = *this;
+
+    if ( p_symmetry & BOARD_SYMMETRY_MIRROR )
+    {
+      l_result = l_result.mirror();
+    }
+    if ( p_symmetry & BOARD_SYMMETRY_FLIP )
+    {
+      l_result = l_result.flip();
+    }
+    if constexpr ( W == H )
+    {
+      if ( p_symmetry & BOARD_SYMMETRY_TRANSPOSE )
+      {
+        l_result = l_result.transpose();
+      }
+    }
+
+    return l_result;
+  }
+
+
+  /*
+   * canonical - returns the smallest of the board's symmetric forms; all
+   *             eight rotations and reflections of a square board (or the
+   *             four reflections of any other) give the same result. If
+   *             p_symmetry is provided, it is set to the transform() which
+   *             produced it.
+   */
+
+  Board canonical( uint_fast8_t *p_symmetry = nullptr ) const
+  {
+    constexpr uint_fast8_t l_count = ( W == H ) ? BOARD_SYMMETRIES : BOARD_SYMMETRIES / 2;
+    Board                  l_forms[BOARD_SYMMETRIES];
+    uint_fast8_t           l_best = 0;
+
+    /* Build each form from an earlier one, with a single step each. */
+    l_forms[0] = *this;
+    l_forms[BOARD_SYMMETRY_MIRROR] = mirror();
+    l_forms[BOARD_SYMMETRY_FLIP] = flip();
+    l_forms[BOARD_SYMMETRY_MIRROR | BOARD_SYMMETRY_FLIP] = l_forms[BOARD_SYMMETRY_MIRROR].flip();
+    if constexpr ( W == H )
+    {
+      for ( uint_fast8_t l_form = 0; l_form < BOARD_SYMMETRY_TRANSPOSE; l_form++ )
+      {
+        l_forms[l_form | BOARD_SYMMETRY_TRANSPOSE] = l_forms[l_form].transpose();
+      }
+    }
+
+    /* And pick the smallest. */
+    for ( uint_fast8_t l_form = 1; l_form < l_count; l_form++ )
+    {
+      if ( l_forms[l_form] < l_forms[l_best] )
+      {
+        l_best = l_form;
+      }
+    }
+
+    if ( p_symmetry != nullptr )
+    {
+      *p_symmetry = l_best;
+    }
+    return l_forms[l_best];
+  }
+
+
+  /*
+   * slide - returns the board after sliding all tiles in the requested
+   *         direction, merging as they go.
+   */
+
+  Board slide( direction_t p_direction ) const
+  {
+    Board l_result = {};
+    bool  l_reverse = ( p_direction == DIRECTION_DOWN ) || ( p_direction == DIRECTION_RIGHT );
+
+    /* Horizontal moves are a lookup (or a kernel call) per row. */
+    if ( ( p_direction == DIRECTION_LEFT ) || ( p_direction == DIRECTION_RIGHT ) )
+    {
+      for ( uint_fast8_t l_row = 0; l_row < H; l_row++ )
+      {
+        l_result.m_words[l_row / rows_per_word] |=
+          (word_t)board_row_move<W, B>( row( l_row ), l_reverse ) << ( ( l_row % rows_per_word ) * row_bits );
+      }
+      return l_result;
+    }
+
+    /* Square boards in a single word can transpose cheaply and use rows. */
+    if constexpr ( ( W == H ) && ( words == 1 ) && g_row_tabled<W, B> )
+    {
+      return transpose().slide( l_reverse ? DIRECTION_RIGHT : DIRECTION_LEFT ).transpose();
+    }
+    else
+    {
+      for ( uint_fast8_t l_col = 0; l_col < W; l_col++ )
+      {
+        l_result.set_column( l_col, board_row_move<H, B>( column( l_col ), l_reverse ) );
+      }
+      return l_result;
+    }
+  }
+
+
+  /*
+   * legal_moves - returns a mask of DIRECTION_BIT()s for every direction
+   *               that would change the board, without making any moves;
+   *               when this is zero, the game is over.
+   */
+
+  uint_fast8_t legal_moves( void ) const
+  {
+    uint_fast8_t l_rows = 0, l_columns = 0;
+
+    /* Rows are looked up directly. */
+    for ( uint_fast8_t l_row = 0; l_row < H; l_row++ )
+    {
+      l_rows |= board_row_legal<W, B>( row( l_row ) );
+    }
+
+    /* Columns are looked up as rows of the transposed board, if we can. */
+    if constexpr ( ( W == H ) && ( words == 1 ) && g_row_tabled<W, B> )
+    {
+      Board l_transposed = transpose();
+
+      for ( uint_fast8_t l_row = 0; l_row < H; l_row++ )
+      {
+        l_columns |= board_row_legal<W, B>( l_transposed.row( l_row ) );
+      }
+    }
+    else
+    {
+      for ( uint_fast8_t l_col = 0; l_col < W; l_col++ )
+      {
+        l_columns |= board_row_legal<H, B>( column( l_col ) );
+      }
+    }
+
+    /* And map the row flags onto directions. */
+    return ( ( l_rows & ROW_LEGAL_LEFT ) ? DIRECTION_BIT( DIRECTION_LEFT ) : 0 ) |
+           ( ( l_rows & ROW_LEGAL_RIGHT ) ? DIRECTION_BIT( DIRECTION_RIGHT ) : 0 ) |
+           ( ( l_columns & ROW_LEGAL_LEFT ) ? DIRECTION_BIT( DIRECTION_UP ) : 0 ) |
+           ( ( l_columns & ROW_LEGAL_RIGHT ) ? DIRECTION_BIT( DIRECTION_DOWN ) : 0 );
+  }
+
+
+  /*
+   * move - slides the board in the requested direction, handing back the
+   *        new board along with its empty cells, the score the move earned
+   *        and the largest exponent left on the board.
+   */
+
+  move_result_t<Board> move( direction_t p_direction ) const
+  {
+    move_result_t<Board> l_result = {};
+    bool                 l_reverse = ( p_direction == DIRECTION_DOWN ) || ( p_direction == DIRECTION_RIGHT );
+
+    if ( ( p_direction == DIRECTION_LEFT ) || ( p_direction == DIRECTION_RIGHT ) )
+    {
+      move_rows( *this, l_reverse, &l_result );
+    }
+    else if constexpr ( ( W == H ) && ( words == 1 ) && g_row_tabled<W, B> )
+    {
+      move_rows( transpose(), l_reverse, &l_result );
+      l_result.board = l_result.board.transpose();
+    }
+    else
+    {
+      for ( uint_fast8_t l_col = 0; l_col < W; l_col++ )
+      {
+        row_t l_column = column( l_col );
+
+        l_result.board.set_column( l_col, board_row_move<H, B>( l_column, l_reverse ) );
+        move_account( board_row_info<H, B>( l_column, l_reverse ), &l_result );
+      }
+    }
+
+    l_result.empty = l_result.board.empty_mask();
+    return l_result;
+  }
+
+
+  /*
+   * move_rows - slides every row of p_board, building up the result; the
+   *             board in p_result must start out empty.
+   */
+
+  static void move_rows( const Board &p_board, bool p_reverse, move_result_t<Board> *p_result )
+  {
+    for ( uint_fast8_t l_row = 0; l_row < H; l_row++ )
+    {
+      row_t l_cells = p_board.row( l_row );
+
+      p_result->board.m_words[l_row / rows_per_word] |=
+        (word_t)board_row_move<W, B>( l_cells, p_reverse ) << ( ( l_row % rows_per_word ) * row_bits );
+      move_account( board_row_info<W, B>( l_cells, p_reverse ), p_result );
+    }
+  }
+
+
+  /*
+   * move_account - adds one row's ROW_INFO() into a move's score and max.
+   */
+
+  static void move_account( uint_fast16_t p_info, move_result_t<Board> *p_result )
+  {
+    p_result->score += board_cell_value( ROW_INFO_MERGED( p_info, B ) );
+    if ( ROW_INFO_MAX( p_info, B ) > p_result->max_exponent )
+    {
+      p_result->max_exponent = ROW_INFO_MAX( p_info, B );
+    }
+  }
+
+
+  /*
+   * empty_mask - returns the mask of empty cells on the board. Single word
+   *              boards of nibbles have their cells evenly spaced, so the
+   *              whole word can be folded at once.
+   */
+
+  cellmask_t empty_mask( void ) const
+  {
+    if constexpr ( ( words == 1 ) && ( B == 4 ) )
+    {
+      uint64_t l_zeros = m_words[0];
+
+      /* Fold each nibble onto its lowest bit, set where it's empty... */
+      l_zeros = ~( l_zeros | ( l_zeros >> 1 ) | ( l_zeros >> 2 ) | ( l_zeros >> 3 ) ) & 0x1111111111111111ull;
+
+      /* ...and squeeze those bits together, doubling up each step. */
+      l_zeros = ( l_zeros | ( l_zeros >> 3 ) ) & 0x0303030303030303ull;
+      l_zeros = ( l_zeros | ( l_zeros >> 6 ) ) & 0x000F000F000F000Full;
+      l_zeros = ( l_zeros | ( l_zeros >> 12 ) ) & 0x000000FF000000FFull;
+      l_zeros = ( l_zeros | ( l_zeros >> 24 ) ) & 0xFFFFull;
+
+      return l_zeros & all_cells;
+    }
+    else
+    {
+      cellmask_t l_result = 0;
+
+      for ( uint_fast8_t l_row = 0; l_row < H; l_row++ )
+      {
+        l_result |= (cellmask_t)board_row_empty<W, B>( row( l_row ) ) << ( l_row * W );
+      }
+
+      return l_result;
+    }
+  }
+
+
+  /*
+   * empty_count - returns the number of empty cells on the board.
+   */
+
+  uint_fast8_t empty_count( void ) const
+  {
+    return bits_count( empty_mask() );
+  }
+
+
+  /*
+   * empty_cell - returns the index (row * W + col) of the nth empty cell,
+   *              counting from the top left; p_nth must be less than the
+   *              empty_count().
+   */
+
+  uint_fast8_t empty_cell( uint_fast8_t p_nth ) const
+  {
+    return bits_select( empty_mask(), p_nth );
+  }
+
+
+  /*
+   * hash - returns the Zobrist hash of the board, from scratch; the xor of
+   *        the keys of every cell's exponent.
+   */
+
+  uint64_t hash( void ) const
+  {
+    uint64_t l_hash = 0;
+
+    for ( uint_fast8_t l_row = 0; l_row < H; l_row++ )
+    {
+      for ( uint_fast8_t l_col = 0; l_col < W; l_col++ )
+      {
+        l_hash ^= g_board_keys[l_row * W + l_col][cell( l_row, l_col )];
+      }
+    }
+
+    return l_hash;
+  }
+
+
+  /*
+   * rehash - given this board's hash, returns the hash of p_to by visiting
+   *          only the cells that differ between the two; the changed cells
+   *          fall straight out of an xor of the packed words.
+   */
+
+  uint64_t rehash( uint64_t p_hash, const Board &p_to ) const
+  {
+    for ( uint_fast8_t l_word = 0; l_word < words; l_word++ )
+    {
+      word_t      l_diff = m_words[l_word] ^ p_to.m_words[l_word];
+      uint64_t    l_changed = l_diff;
+
+      /* Fold each cell's difference onto its lowest bit. */
+      for ( uint_fast8_t l_bit = 1; l_bit < B; l_bit++ )
+      {
+        l_changed |= l_diff >> l_bit;
+      }
+      l_changed &= cell_bases();
+
+      /* And swap the keys of those cells. */
+      while( l_changed != 0 )
+      {
+        uint_fast8_t l_shift = bits_first( l_changed );
+
+        p_hash = board_hash_cell( p_hash, ( l_word * rows_per_word * W ) + ( l_shift / B ),
+                                  ( m_words[l_word] >> l_shift ) & cell_mask,
+                                  ( p_to.m_words[l_word] >> l_shift ) & cell_mask );
+        l_changed &= l_changed - 1;
+      }
+    }
+
+    return p_hash;
+  }
+
+
+  /*
+   * cell_bases - returns a mask of the lowest bit of every cell in a word.
+   */
+
+  static constexpr uint64_t cell_bases( void )
+  {
+    uint64_t l_mask = 0;
+
+    for ( uint_fast8_t l_cell = 0; l_cell < rows_per_word * W && l_cell * B < 64; l_cell++ )
+    {
+      l_mask |= (uint64_t)1 << ( l_cell * B );
+    }
+
+    return l_mask;
+  }
+
+
+  /*
+   * Comparisons are straight comparisons of the packed words.
+   */
+
+  bool operator==( const Board &p_other ) const
+  {
+    for ( uint_fast8_t l_word = 0; l_word < words; l_word++ )
+    {
+      if ( m_words[l_word] != p_other.m_words[l_word] )
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool operator!=( const Board &p_other ) const
+  {
+    return !( *this == p_other );
+  }
+
+  bool operator<( const Board &p_other ) const
+  {
+    for ( uint_fast8_t l_word = words; l_word-- > 0; )
+    {
+      if ( m_words[l_word] != p_other.m_words[l_word] )
+      {
+        return m_words[l_word] < p_other.m_words[l_word];
+      }
+    }
+    return false;
+  }
+};
+
+
+/* Functions in board.cpp. */
+
+bool board_verify_tables( void );
+
+#endif /* _ENGINE_BOARD_HPP_ */
+
+/* End of file engine/board.hpp */
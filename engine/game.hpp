@@ -0,0 +1,141 @@
+/*
+ * engine/game.hpp; the rules of a game of 2040-eight, without any of the
+ * presentation.
+ *
+ * A game_t holds everything about a game in progress; the board, its empty
+ * cells and legal moves, its Zobrist hash, the score so far and its own
+ * random number generator. Spawning a tile and making a move keep all of
+ * these up to date together, so anything playing games (the handheld, the
+ * simulator, a search) gets exactly the same rules, and the same sequence
+ * of tiles from the same seed.
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+#ifndef _ENGINE_GAME_HPP_
+#define _ENGINE_GAME_HPP_
+
+/* System headers. */
+
+#include <cstdint>
+
+
+/* Local headers. */
+
+#include "board.hpp"
+#include "rng.hpp"
+
+
+/* Local structures and types. */
+
+template<typename B>
+struct game_t
+{
+  B             board;
+  cellmask_t    empty;
+  uint_fast8_t  legal;
+  uint64_t      hash;
+  uint64_t      score;
+  uint_fast8_t  max_exponent;
+  uint32_t      moves;
+  rng_t         rng;
+};
+
+
+/* Functions. */
+
+/*
+ * game_reset - clears the board and starts a new game from the given seed;
+ *              the first tile still needs spawning.
+ */
+
+template<typename B>
+void game_reset( game_t<B> *p_game, uint64_t p_seed )
+{
+  p_game->board = {};
+  p_game->empty = B::all_cells;
+  p_game->legal = 0;
+  p_game->hash = 0;
+  p_game->score = 0;
+  p_game->max_exponent = 0;
+  p_game->moves = 0;
+  rng_seed( &p_game->rng, p_seed );
+}
+
+
+/*
+ * game_spawn - drops a new tile into a random empty cell, and works out
+ *              which moves are then legal; returns false if there was no
+ *              room for it. If p_pick is provided, it is set to the tile
+ *              placed. The game is over once this leaves no legal moves.
+ */
+
+template<typename B>
+bool game_spawn( game_t<B> *p_game, spawn_pick_t *p_pick = nullptr )
+{
+  spawn_pick_t l_pick;
+
+  if ( p_game->empty == 0 )
+  {
+    return false;
+  }
+
+  /* Pick the cell and value in one go, and claim the cell. */
+  l_pick = board_spawn_pick( p_game->empty, &p_game->rng );
+  p_game->board.set_cell( l_pick.cell / B::width, l_pick.cell % B::width, l_pick.exponent );
+  p_game->empty &= ~( (cellmask_t)1 << l_pick.cell );
+  p_game->hash = board_hash_cell( p_game->hash, l_pick.cell, 0, l_pick.exponent );
+  if ( l_pick.exponent > p_game->max_exponent )
+  {
+    p_game->max_exponent = l_pick.exponent;
+  }
+
+  /* With the board settled, see which ways it can move now. */
+  p_game->legal = p_game->board.legal_moves();
+
+  if ( p_pick != nullptr )
+  {
+    *p_pick = l_pick;
+  }
+  return true;
+}
+
+
+/*
+ * game_move - makes a move, if it's legal; returns false (and leaves the
+ *             game alone) if not. If p_moved is provided, it is set to the
+ *             full result of the move. No moves are legal again until the
+ *             next tile has been spawned.
+ */
+
+template<typename B>
+bool game_move( game_t<B> *p_game, direction_t p_direction, move_result_t<B> *p_moved = nullptr )
+{
+  move_result_t<B> l_moved;
+
+  if ( ( p_game->legal & DIRECTION_BIT( p_direction ) ) == 0 )
+  {
+    return false;
+  }
+
+  /* The move itself brings back almost everything we need. */
+  l_moved = p_game->board.move( p_direction );
+  p_game->hash = p_game->board.rehash( p_game->hash, l_moved.board );
+  p_game->board = l_moved.board;
+  p_game->empty = l_moved.empty;
+  p_game->score += l_moved.score;
+  p_game->max_exponent = l_moved.max_exponent;
+  p_game->legal = 0;
+  p_game->moves++;
+
+  if ( p_moved != nullptr )
+  {
+    *p_moved = l_moved;
+  }
+  return true;
+}
+
+#endif /* _ENGINE_GAME_HPP_ */
+
+/* End of file engine/game.hpp */
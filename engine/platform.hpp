@@ -0,0 +1,46 @@
+/*
+ * engine/platform.hpp; the little the engine needs from the machine it's
+ * running on.
+ *
+ * On the PicoSystem that's the SDK; host builds (which define ENGINE_HOST)
+ * use the standard library instead, so the engine and its tools can be
+ * built, profiled and benchmarked on an ordinary workstation.
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+#ifndef _ENGINE_PLATFORM_HPP_
+#define _ENGINE_PLATFORM_HPP_
+
+/* System headers. */
+
+#include <cstdint>
+
+#if defined( ENGINE_HOST )
+#include <chrono>
+#else
+#include "picosystem.hpp"
+#endif
+
+
+/* Functions. */
+
+/*
+ * platform_time_us - returns a monotonic time in microseconds; only the
+ *                    difference between two readings means anything.
+ */
+
+inline uint64_t platform_time_us( void )
+{
+#if defined( ENGINE_HOST )
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch() ).count();
+#else
+  return picosystem::time_us();
+#endif
+}
+
+#endif /* _ENGINE_PLATFORM_HPP_ */
+
+/* End of file engine/platform.hpp */
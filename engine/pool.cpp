@@ -0,0 +1,249 @@
+/*
+ * engine/pool.cpp; a work-stealing pool of threads, for host builds.
+ *
+ * Each queue has a lock of its own, held only for a push, pop or steal,
+ * so threads only ever contend over the one queue they both touch. Idle
+ * threads sleep until a task is pushed, rather than spinning between
+ * searches.
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+/* System headers. */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/* Local headers. */
+
+#include "pool.hpp"
+
+
+/* Local structures and types. */
+
+typedef struct
+{
+  std::mutex              lock;
+  std::deque<pool_task_t> tasks;
+} pool_queue_t;
+
+struct pool_t
+{
+  uint32_t                  threads;
+  pool_queue_t             *queues;
+  std::vector<std::thread>  workers;
+  std::atomic<uint32_t>     queued;
+  std::atomic<uint32_t>     sleeping;
+  std::atomic<bool>         stopping;
+  std::mutex                sleep_lock;
+  std::condition_variable   wake;
+};
+
+
+/* Module variables. */
+
+/* Which pool this thread works for, and which queue is its own. */
+static thread_local const pool_t *g_pool_owner = nullptr;
+static thread_local uint32_t      g_pool_index = 0;
+
+
+/* Functions. */
+
+/*
+ * pool_index - returns the calling thread's queue in the pool; any thread
+ *              which isn't one of the pool's own workers is thread zero.
+ */
+
+static uint32_t pool_index( const pool_t *p_pool )
+{
+  return ( g_pool_owner == p_pool ) ? g_pool_index : 0;
+}
+
+
+/*
+ * pool_run_one - runs a single task, from the thread's own queue if it can,
+ *                otherwise stolen from another; returns false if there was
+ *                nothing to run.
+ */
+
+static bool pool_run_one( pool_t *p_pool, uint32_t p_index )
+{
+  pool_task_t l_task;
+  bool        l_found = false;
+
+  /* Newest first from our own queue... */
+  {
+    std::lock_guard<std::mutex> l_guard( p_pool->queues[p_index].lock );
+    if ( !p_pool->queues[p_index].tasks.empty() )
+    {
+      l_task = p_pool->queues[p_index].tasks.back();
+      p_pool->queues[p_index].tasks.pop_back();
+      l_found = true;
+    }
+  }
+
+  /* ...then oldest first from everyone else's. */
+  for ( uint32_t l_step = 1; !l_found && l_step < p_pool->threads; l_step++ )
+  {
+    pool_queue_t &l_victim = p_pool->queues[( p_index + l_step ) % p_pool->threads];
+
+    std::lock_guard<std::mutex> l_guard( l_victim.lock );
+    if ( !l_victim.tasks.empty() )
+    {
+      l_task = l_victim.tasks.front();
+      l_victim.tasks.pop_front();
+      l_found = true;
+    }
+  }
+
+  if ( !l_found )
+  {
+    return false;
+  }
+
+  p_pool->queued.fetch_sub( 1 );
+  l_task.fn( l_task.arg );
+  l_task.pending->fetch_sub( 1, std::memory_order_release );
+  return true;
+}
+
+
+/*
+ * pool_worker - the body of each of the pool's own threads.
+ */
+
+static void pool_worker( pool_t *p_pool, uint32_t p_index )
+{
+  g_pool_owner = p_pool;
+  g_pool_index = p_index;
+
+  while( !p_pool->stopping.load() )
+  {
+    if ( pool_run_one( p_pool, p_index ) )
+    {
+      continue;
+    }
+
+    /* Nothing to do; sleep until something is pushed. */
+    std::unique_lock<std::mutex> l_guard( p_pool->sleep_lock );
+    p_pool->sleeping.fetch_add( 1 );
+    p_pool->wake.wait( l_guard, [p_pool] { return p_pool->stopping.load() || p_pool->queued.load() > 0; } );
+    p_pool->sleeping.fetch_sub( 1 );
+  }
+}
+
+
+/*
+ * pool_create - starts a pool of p_threads threads, counting the caller as
+ *               one of them; at least one.
+ */
+
+pool_t *pool_create( uint32_t p_threads )
+{
+  pool_t *l_pool = new pool_t;
+
+  l_pool->threads = ( p_threads > 0 ) ? p_threads : 1;
+  l_pool->queues = new pool_queue_t[l_pool->threads];
+  l_pool->queued = 0;
+  l_pool->sleeping = 0;
+  l_pool->stopping = false;
+
+  for ( uint32_t l_index = 1; l_index < l_pool->threads; l_index++ )
+  {
+    l_pool->workers.emplace_back( pool_worker, l_pool, l_index );
+  }
+  return l_pool;
+}
+
+
+/*
+ * pool_destroy - stops the pool's threads, and frees it; there must be no
+ *                tasks still outstanding.
+ */
+
+void pool_destroy( pool_t *p_pool )
+{
+  if ( p_pool == nullptr )
+  {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> l_guard( p_pool->sleep_lock );
+    p_pool->stopping = true;
+  }
+  p_pool->wake.notify_all();
+  for ( std::thread &l_worker : p_pool->workers )
+  {
+    l_worker.join();
+  }
+
+  delete[] p_pool->queues;
+  delete p_pool;
+}
+
+
+/*
+ * pool_threads - returns the number of threads in the pool.
+ */
+
+uint32_t pool_threads( const pool_t *p_pool )
+{
+  return p_pool->threads;
+}
+
+
+/*
+ * pool_push - queues a task on the calling thread's own queue, waking a
+ *             sleeping thread to come and steal it.
+ */
+
+void pool_push( pool_t *p_pool, const pool_task_t *p_task )
+{
+  pool_queue_t &l_queue = p_pool->queues[pool_index( p_pool )];
+
+  /* Count the task before anyone can see it; whoever takes it counts */
+  /* it off again, and mustn't be able to get there first.            */
+  {
+    std::lock_guard<std::mutex> l_guard( l_queue.lock );
+    p_pool->queued.fetch_add( 1 );
+    l_queue.tasks.push_back( *p_task );
+  }
+
+  /* A thread going to sleep checks the count after saying so, so it */
+  /* can't miss this.                                                */
+  if ( p_pool->sleeping.load() > 0 )
+  {
+    std::lock_guard<std::mutex> l_guard( p_pool->sleep_lock );
+    p_pool->wake.notify_one();
+  }
+}
+
+
+/*
+ * pool_wait - runs tasks until the given counter of outstanding tasks
+ *             drops to zero.
+ */
+
+void pool_wait( pool_t *p_pool, std::atomic<uint32_t> *p_pending )
+{
+  uint32_t l_index = pool_index( p_pool );
+
+  while( p_pending->load( std::memory_order_acquire ) != 0 )
+  {
+    if ( !pool_run_one( p_pool, l_index ) )
+    {
+      std::this_thread::yield();
+    }
+  }
+}
+
+
+/* End of file engine/pool.cpp */
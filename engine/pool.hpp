@@ -0,0 +1,56 @@
+/*
+ * engine/pool.hpp; a work-stealing pool of threads, for host builds.
+ *
+ * Work is handed out as tasks; a function, its argument, and a counter of
+ * outstanding tasks which it decrements when done. Every thread has its own
+ * queue, pushing and popping at the back of it, so nested work stays with
+ * the thread which made it (and its caches); a thread with nothing left
+ * steals from the front of another's queue, taking the oldest and (in a
+ * search) biggest piece of work there is.
+ *
+ * Waiting for tasks to finish is never idle; the waiting thread runs queued
+ * tasks (its own, or stolen ones) until its counter reaches zero, so tasks
+ * may push and wait on tasks of their own. The thread which created the
+ * pool takes part too, as thread zero; only one outside thread should use
+ * a pool at a time.
+ *
+ * The threads themselves live in pool.cpp, which only host builds have.
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+#ifndef _ENGINE_POOL_HPP_
+#define _ENGINE_POOL_HPP_
+
+/* System headers. */
+
+#include <atomic>
+#include <cstdint>
+
+
+/* Local structures and types. */
+
+typedef void (*pool_fn_t)( void *p_arg );
+
+typedef struct
+{
+  pool_fn_t               fn;
+  void                   *arg;
+  std::atomic<uint32_t>  *pending;
+} pool_task_t;
+
+struct pool_t;
+
+
+/* Functions in pool.cpp. */
+
+pool_t   *pool_create( uint32_t p_threads );
+void      pool_destroy( pool_t *p_pool );
+uint32_t  pool_threads( const pool_t *p_pool );
+void      pool_push( pool_t *p_pool, const pool_task_t *p_task );
+void      pool_wait( pool_t *p_pool, std::atomic<uint32_t> *p_pending );
+
+#endif /* _ENGINE_POOL_HPP_ */
+
+/* End of file engine/pool.hpp */
@@ -0,0 +1,159 @@
+/*
+ * engine/rng.hpp; a small, fast, seedable random number generator.
+ *
+ * This is xoshiro128** (Blackman and Vigna); 128 bits of state, and nothing
+ * but 32-bit shifts, rotates and xors per number, which suits the RP2040's
+ * Cortex-M0+ far better than anything needing 64-bit multiplies. All state
+ * lives in an rng_t owned by the caller, so there are no locks and no hidden
+ * globals; a game (or a simulation thread) seeded the same way will always
+ * see the same sequence, on any platform.
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+#ifndef _ENGINE_RNG_HPP_
+#define _ENGINE_RNG_HPP_
+
+/* System headers. */
+
+#include <cstdint>
+
+
+/* Local structures and types. */
+
+typedef struct
+{
+  uint32_t  state[4];
+} rng_t;
+
+
+/* Functions. */
+
+/*
+ * rng_rotl - rotates a 32-bit value left.
+ */
+
+inline uint32_t rng_rotl( uint32_t p_value, uint_fast8_t p_bits )
+{
+  return ( p_value << p_bits ) | ( p_value >> ( 32 - p_bits ) );
+}
+
+
+/*
+ * rng_splitmix - steps a splitmix64 generator; only used to spread a seed
+ *                out over the full state.
+ */
+
+constexpr uint64_t rng_splitmix( uint64_t *p_seed )
+{
+  uint64_t l_value = ( *p_seed += 0x9E3779B97F4A7C15ull );
+
+  l_value = ( l_value ^ ( l_value >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+  l_value = ( l_value ^ ( l_value >> 27 ) ) * 0x94D049BB133111EBull;
+  return l_value ^ ( l_value >> 31 );
+}
+
+
+/*
+ * rng_seed - initialises a generator from a 64-bit seed.
+ */
+
+inline void rng_seed( rng_t *p_rng, uint64_t p_seed )
+{
+  uint64_t l_mixed;
+
+  /* Splitmix never hands out all zeros twice, so the state is never zero. */
+  l_mixed = rng_splitmix( &p_seed );
+  p_rng->state[0] = (uint32_t)l_mixed;
+  p_rng->state[1] = (uint32_t)( l_mixed >> 32 );
+  l_mixed = rng_splitmix( &p_seed );
+  p_rng->state[2] = (uint32_t)l_mixed;
+  p_rng->state[3] = (uint32_t)( l_mixed >> 32 );
+}
+
+
+/*
+ * rng_next - returns the next 32 random bits.
+ */
+
+inline uint32_t rng_next( rng_t *p_rng )
+{
+  uint32_t *l_state = p_rng->state;
+  uint32_t  l_result = rng_rotl( l_state[1] * 5, 7 ) * 9;
+  uint32_t  l_shifted = l_state[1] << 9;
+
+  l_state[2] ^= l_state[0];
+  l_state[3] ^= l_state[1];
+  l_state[1] ^= l_state[2];
+  l_state[0] ^= l_state[3];
+  l_state[2] ^= l_shifted;
+  l_state[3] = rng_rotl( l_state[3], 11 );
+
+  return l_result;
+}
+
+
+/*
+ * rng_below - returns a random number from 0 to p_limit-1, by scaling the
+ *             next 32 bits rather than taking a (slow, biased) modulus. The
+ *             remaining bias is below p_limit / 2^32, which for the sizes
+ *             we pick from is far too small to matter.
+ */
+
+inline uint32_t rng_below( rng_t *p_rng, uint32_t p_limit )
+{
+  return ( (uint64_t)rng_next( p_rng ) * p_limit ) >> 32;
+}
+
+
+/*
+ * rng_jump - advances the generator by 2^64 steps; used to carve one seed
+ *            up into non-overlapping streams.
+ */
+
+inline void rng_jump( rng_t *p_rng )
+{
+  static const uint32_t l_jump[] = { 0x8764000B, 0xF542D2D3, 0x6FA035C3, 0x77F2DB5B };
+  uint32_t              l_state[4] = { 0, 0, 0, 0 };
+
+  for ( uint_fast8_t l_word = 0; l_word < 4; l_word++ )
+  {
+    for ( uint_fast8_t l_bit = 0; l_bit < 32; l_bit++ )
+    {
+      if ( l_jump[l_word] & ( 1u << l_bit ) )
+      {
+        for ( uint_fast8_t l_index = 0; l_index < 4; l_index++ )
+        {
+          l_state[l_index] ^= p_rng->state[l_index];
+        }
+      }
+      rng_next( p_rng );
+    }
+  }
+
+  for ( uint_fast8_t l_index = 0; l_index < 4; l_index++ )
+  {
+    p_rng->state[l_index] = l_state[l_index];
+  }
+}
+
+
+/*
+ * rng_stream - initialises a generator to the given stream of a seed; each
+ *              stream is 2^64 numbers long, and no two overlap, so every
+ *              thread can have a stream of its own.
+ */
+
+inline void rng_stream( rng_t *p_rng, uint64_t p_seed, uint32_t p_stream )
+{
+  rng_seed( p_rng, p_seed );
+  while( p_stream-- > 0 )
+  {
+    rng_jump( p_rng );
+  }
+}
+
+#endif /* _ENGINE_RNG_HPP_ */
+
+/* End of file engine/rng.hpp */
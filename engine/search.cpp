@@ -0,0 +1,34 @@
+/*
+ * engine/search.cpp; the compile-time line evaluation tables.
+ *
+ * As with the row tables in board.cpp, these are defined here and nowhere
+ * else, so the compiler builds them once rather than in every file which
+ * includes search.hpp, and the constexpr definitions keep them in flash.
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+/* System headers. */
+
+#include <cstdint>
+
+
+/* Local headers. */
+
+#include "search.hpp"
+
+
+/* Globals. */
+
+template<uint_fast8_t W, uint_fast8_t B>
+constexpr search_line_table_t<W, B> search_tables_t<W, B>::line = search_build_line_table<W, B>();
+
+template struct search_tables_t<2, 4>;
+template struct search_tables_t<3, 4>;
+template struct search_tables_t<4, 4>;
+template struct search_tables_t<2, 5>;
+template struct search_tables_t<3, 5>;
+
+
+/* End of file engine/search.cpp */
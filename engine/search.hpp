@@ -0,0 +1,793 @@
+/*
+ * engine/search.hpp; expectimax search for the best move.
+ *
+ * The search alternates two kinds of node. At a player node every legal
+ * move is tried, and the best is taken; at a chance node, the board left
+ * by a move has every possible spawn added in turn (each empty cell, with
+ * a '2' or a '4' weighted as board_spawn_pick() weights them) and the
+ * results are averaged. Depth is counted in player moves, so a depth of
+ * one simply evaluates the board each move leaves behind.
+ *
+ * Positions at the bottom of the search get a static evaluation, built up
+ * from each row and column on its own; empty cells and neighbours ready to
+ * merge count for a line, tiles out of order along it and large tiles in
+ * general count against it. A board with no moves left is worth nothing.
+ * Where rows fit the board's row tables, the value of every possible line
+ * is worked out at compile time too, so a whole 4x4 board is evaluated
+ * with eight lookups.
+ *
+ * Given a transposition table, the value of every board left by a move is
+ * kept against its Zobrist hash (which is updated cell by cell on the way
+ * down), so reaching it again by another order of spawns costs a lookup.
+ * Tables are only available to host builds.
+ *
+ * Host builds can also spread a search over a pool of threads. The moves
+ * at the root are tasks of their own, as are the spawns of any chance node
+ * with SEARCH_SPLIT_DEPTH or more moves still to go; the pool's threads
+ * steal whichever of these are waiting, and all of them share the table.
+ *
+ * Most of a deep search is spent on spawns which are very unlikely to all
+ * happen, so the chance of reaching each node is tracked on the way down;
+ * a board which is less likely than the options' cutoff is given a static
+ * evaluation instead of being searched, and counted as pruned. Once the
+ * allowed number of '4's have spawned on the way to a board, only '2's are
+ * spawned on it, and each '4' left out is counted as capped. A board's
+ * value depends on how many '4's it may still see, so where that's fewer
+ * than the moves left to search, it is mixed into the board's key in the
+ * table.
+ *
+ * For hints and autoplay, search_timed() deepens one move at a time until
+ * a budget of microseconds (on the same clock update() uses) runs out,
+ * and keeps the move from the deepest search it finished; a search cut
+ * off partway is thrown away, and anything it would have stored in the
+ * table is never stored. The clock is only read every SEARCH_CLOCK_NODES
+ * nodes, so a search overruns its budget by a little.
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+#ifndef _ENGINE_SEARCH_HPP_
+#define _ENGINE_SEARCH_HPP_
+
+/* System headers. */
+
+#include <array>
+#include <cstdint>
+
+
+/* Local headers. */
+
+#include "bits.hpp"
+#include "board.hpp"
+#include "platform.hpp"
+#include "pool.hpp"
+#include "rng.hpp"
+#include "ttable.hpp"
+
+
+/* Constants. */
+
+#define SEARCH_DEFAULT_DEPTH  3
+#define SEARCH_SPLIT_DEPTH    2
+#define SEARCH_DEFAULT_CUTOFF 0.0001
+#define SEARCH_DEFAULT_FOURS  4
+#define SEARCH_FOURS_SEED     0x2040F0025ull
+
+/* How many nodes go by between looks at the clock; a node on the RP2040 */
+/* costs a hundred times or more what it does on the host, so it looks   */
+/* far more often there, to keep the overrun to a fraction of a frame.   */
+#if defined( ENGINE_HOST )
+#define SEARCH_CLOCK_NODES    1024
+#else
+#define SEARCH_CLOCK_NODES    16
+#endif
+
+/* Weights for the static evaluation of a line. */
+#define SEARCH_LINE_BASE      200000
+#define SEARCH_EMPTY_WEIGHT   270
+#define SEARCH_MERGE_WEIGHT   700
+#define SEARCH_ORDER_WEIGHT   47
+#define SEARCH_SUM_WEIGHT     11
+
+/* The chance of each spawned value, as board_spawn_pick() has it. */
+#define SEARCH_FOUR_CHANCE    ( BOARD_SPAWN_FOUR_PERCENT / 100.0 )
+#define SEARCH_TWO_CHANCE     ( 1.0 - SEARCH_FOUR_CHANCE )
+
+
+/* Local structures and types. */
+
+/* How a search is to be carried out. */
+typedef struct
+{
+  uint_fast8_t  depth;
+  double        cutoff;
+  uint_fast8_t  max_fours;
+  ttable_t     *table;
+  pool_t       *pool;
+  uint64_t      start_us;
+  uint32_t      budget_us;
+} search_options_t;
+
+typedef struct
+{
+  direction_t   direction;
+  double        value;
+  uint64_t      nodes;
+  uint64_t      table_hits;
+  uint64_t      pruned;
+  uint64_t      capped;
+  uint_fast8_t  depth;
+  bool          complete;
+} search_result_t;
+
+/* The running state of one search. */
+template<typename B>
+struct search_t
+{
+  const search_options_t *options;
+  uint64_t                nodes;
+  uint64_t                table_hits;
+  uint64_t                pruned;
+  uint64_t                capped;
+  bool                    expired;
+};
+
+/* A key for each number of '4's a search may still spawn. */
+typedef std::array<uint64_t, TTABLE_MAX_DEPTH> search_fours_keys_t;
+
+/* The static value of every possible line of W cells of B bits. */
+template<uint_fast8_t W, uint_fast8_t B>
+using search_line_table_t = std::array<int32_t, ( 1u << ( W * B ) )>;
+
+/* The line tables, for every row width that has row tables; like them,  */
+/* they are built by the compiler in search.cpp and nowhere else.        */
+template<uint_fast8_t W, uint_fast8_t B>
+struct search_tables_t
+{
+  static const search_line_table_t<W, B>  line;
+};
+
+extern template struct search_tables_t<2, 4>;
+extern template struct search_tables_t<3, 4>;
+extern template struct search_tables_t<4, 4>;
+extern template struct search_tables_t<2, 5>;
+extern template struct search_tables_t<3, 5>;
+
+/* A piece of a search, which may be handed to another thread; along with */
+/* the board, it carries the chance of reaching it, and the '4's so far.  */
+template<typename B>
+struct search_task_t
+{
+  search_t<B>   search;
+  B             board;
+  uint64_t      hash;
+  uint_fast8_t  depth;
+  double        chance;
+  uint_fast8_t  fours;
+  double        weight;
+  double        value;
+};
+
+
+/* Functions. */
+
+/*
+ * search_line_value - returns the static evaluation of one row or column
+ *                     of W cells of B bits each.
+ */
+
+template<uint_fast8_t W, uint_fast8_t B>
+constexpr int32_t search_line_value( row_t p_line )
+{
+  int32_t       l_empty = 0, l_merges = 0, l_sum = 0;
+  int32_t       l_rising = 0, l_falling = 0;
+  uint_fast8_t  l_previous = 0;
+
+  for ( uint_fast8_t l_index = 0; l_index < W; l_index++ )
+  {
+    int32_t l_cell = ( p_line >> ( l_index * B ) ) & BOARD_EXP_MASK( B );
+
+    /* Empty cells, and big tiles (which are hard to shift) in general. */
+    if ( l_cell == 0 )
+    {
+      l_empty++;
+    }
+    l_sum += l_cell * l_cell * l_cell;
+
+    /* Neighbours which could merge, ignoring gaps in between. */
+    if ( l_cell != 0 )
+    {
+      if ( l_cell == l_previous )
+      {
+        l_merges++;
+      }
+      l_previous = l_cell;
+    }
+
+    /* And how far the line strays from rising, and from falling. */
+    if ( l_index > 0 )
+    {
+      int32_t l_last = ( p_line >> ( ( l_index - 1 ) * B ) ) & BOARD_EXP_MASK( B );
+      int32_t l_step = ( l_cell * l_cell * l_cell * l_cell ) - ( l_last * l_last * l_last * l_last );
+
+      if ( l_step > 0 )
+      {
+        l_falling += l_step;
+      }
+      else
+      {
+        l_rising -= l_step;
+      }
+    }
+  }
+
+  return SEARCH_LINE_BASE + ( SEARCH_EMPTY_WEIGHT * l_empty ) + ( SEARCH_MERGE_WEIGHT * l_merges )
+       - ( SEARCH_ORDER_WEIGHT * ( ( l_rising < l_falling ) ? l_rising : l_falling ) )
+       - ( SEARCH_SUM_WEIGHT * l_sum );
+}
+
+
+/*
+ * search_build_line_table - evaluates every possible line.
+ */
+
+template<uint_fast8_t W, uint_fast8_t B>
+constexpr search_line_table_t<W, B> search_build_line_table( void )
+{
+  search_line_table_t<W, B> l_table = {};
+
+  for ( row_t l_line = 0; l_line < l_table.size(); l_line++ )
+  {
+    l_table[l_line] = search_line_value<W, B>( l_line );
+  }
+
+  return l_table;
+}
+
+
+/*
+ * search_line - returns the static evaluation of a line; from the table if
+ *               there is one, otherwise worked out afresh.
+ */
+
+template<uint_fast8_t W, uint_fast8_t B>
+inline int32_t search_line( row_t p_line )
+{
+  if constexpr ( g_row_tabled<W, B> )
+  {
+    return search_tables_t<W, B>::line[p_line];
+  }
+  else
+  {
+    return search_line_value<W, B>( p_line );
+  }
+}
+
+
+/*
+ * search_evaluate - returns the static evaluation of a whole board; the
+ *                   sum of that of each of its rows and columns. Square
+ *                   boards in a single word transpose once, so that their
+ *                   columns are looked up as rows, just as legal_moves()
+ *                   does.
+ */
+
+template<typename B>
+double search_evaluate( const B &p_board )
+{
+  int64_t l_value = 0;
+
+  for ( uint_fast8_t l_row = 0; l_row < B::height; l_row++ )
+  {
+    l_value += search_line<B::width, B::cell_bits>( p_board.row( l_row ) );
+  }
+
+  if constexpr ( ( B::width == B::height ) && ( B::words == 1 ) && g_row_tabled<B::width, B::cell_bits> )
+  {
+    B l_transposed = p_board.transpose();
+
+    for ( uint_fast8_t l_row = 0; l_row < B::height; l_row++ )
+    {
+      l_value += search_line<B::width, B::cell_bits>( l_transposed.row( l_row ) );
+    }
+  }
+  else
+  {
+    for ( uint_fast8_t l_col = 0; l_col < B::width; l_col++ )
+    {
+      l_value += search_line<B::height, B::cell_bits>( p_board.column( l_col ) );
+    }
+  }
+
+  return (double)l_value;
+}
+
+
+/*
+ * search_build_fours_keys - generates the keys for the '4's left, in the
+ *                           same way as the board's Zobrist keys.
+ */
+
+constexpr search_fours_keys_t search_build_fours_keys( void )
+{
+  search_fours_keys_t l_keys = {};
+  uint64_t            l_seed = SEARCH_FOURS_SEED;
+
+  for ( uint_fast8_t l_index = 0; l_index < TTABLE_MAX_DEPTH; l_index++ )
+  {
+    l_keys[l_index] = rng_splitmix( &l_seed );
+  }
+
+  return l_keys;
+}
+
+inline constexpr search_fours_keys_t g_search_fours_keys = search_build_fours_keys();
+
+
+/*
+ * search_key - returns the key a chance node is kept under in the table;
+ *              the board's hash, mixed with the number of '4's the search
+ *              may still spawn below it. One '4' at most comes from each
+ *              chance node, so once that's at least p_depth, it makes no
+ *              difference, and the hash is used as it is.
+ */
+
+inline uint64_t search_key( const search_options_t *p_options, uint64_t p_hash, uint_fast8_t p_depth,
+                            uint_fast8_t p_fours )
+{
+  uint_fast8_t l_left = ( p_fours < p_options->max_fours ) ? p_options->max_fours - p_fours : 0;
+
+  return ( l_left < p_depth ) ? p_hash ^ g_search_fours_keys[l_left] : p_hash;
+}
+
+
+/*
+ * search_options - returns the default options for a search of p_depth
+ *                  moves, with the given table and pool (either of which
+ *                  may be nullptr).
+ */
+
+inline search_options_t search_options( uint_fast8_t p_depth = SEARCH_DEFAULT_DEPTH,
+                                        ttable_t *p_table = nullptr, pool_t *p_pool = nullptr )
+{
+  return { p_depth, SEARCH_DEFAULT_CUTOFF, SEARCH_DEFAULT_FOURS, p_table, p_pool, 0, 0 };
+}
+
+
+/*
+ * search_expired - returns true once the search has run out of time; the
+ *                  clock is only checked every so often, and never if there
+ *                  is no budget.
+ */
+
+template<typename B>
+inline bool search_expired( search_t<B> *p_search )
+{
+  const search_options_t *l_options = p_search->options;
+
+  if ( !p_search->expired && l_options->budget_us > 0 && ( p_search->nodes % SEARCH_CLOCK_NODES ) == 0 )
+  {
+    p_search->expired = (uint32_t)( platform_time_us() - l_options->start_us ) >= l_options->budget_us;
+  }
+  return p_search->expired;
+}
+
+
+template<typename B>
+double search_player( search_t<B> *p_search, const B &p_board, uint64_t p_hash, uint_fast8_t p_depth,
+                      double p_chance, uint_fast8_t p_fours );
+
+template<typename B>
+double search_chance( search_t<B> *p_search, const B &p_board, uint64_t p_hash, uint_fast8_t p_depth,
+                      double p_chance, uint_fast8_t p_fours );
+
+
+/*
+ * search_player_task - runs a task as a player node.
+ */
+
+template<typename B>
+void search_player_task( void *p_arg )
+{
+  search_task_t<B> *l_task = (search_task_t<B> *)p_arg;
+
+  l_task->value = search_player( &l_task->search, l_task->board, l_task->hash, l_task->depth,
+                                 l_task->chance, l_task->fours );
+}
+
+
+/*
+ * search_chance_task - runs a task as a chance node.
+ */
+
+template<typename B>
+void search_chance_task( void *p_arg )
+{
+  search_task_t<B> *l_task = (search_task_t<B> *)p_arg;
+
+  l_task->value = search_chance( &l_task->search, l_task->board, l_task->hash, l_task->depth,
+                                 l_task->chance, l_task->fours );
+}
+
+
+/*
+ * search_run_tasks - runs a set of tasks, spread over the pool if there is
+ *                    one, and adds their counts into p_search.
+ */
+
+template<typename B>
+void search_run_tasks( search_t<B> *p_search, pool_fn_t p_fn, search_task_t<B> *p_tasks, uint_fast8_t p_count )
+{
+#if defined( ENGINE_HOST )
+  if ( p_search->options->pool != nullptr )
+  {
+    std::atomic<uint32_t> l_pending( p_count );
+    pool_task_t           l_task = { p_fn, nullptr, &l_pending };
+
+    for ( uint_fast8_t l_index = 0; l_index < p_count; l_index++ )
+    {
+      l_task.arg = &p_tasks[l_index];
+      pool_push( p_search->options->pool, &l_task );
+    }
+    pool_wait( p_search->options->pool, &l_pending );
+  }
+  else
+#endif
+  {
+    for ( uint_fast8_t l_index = 0; l_index < p_count; l_index++ )
+    {
+      p_fn( &p_tasks[l_index] );
+    }
+  }
+
+  for ( uint_fast8_t l_index = 0; l_index < p_count; l_index++ )
+  {
+    p_search->nodes += p_tasks[l_index].search.nodes;
+    p_search->table_hits += p_tasks[l_index].search.table_hits;
+    p_search->pruned += p_tasks[l_index].search.pruned;
+    p_search->capped += p_tasks[l_index].search.capped;
+    p_search->expired |= p_tasks[l_index].search.expired;
+  }
+}
+
+
+/*
+ * search_chance - returns the expected value of a board just after a move,
+ *                 averaged over every tile which could spawn on it. The
+ *                 hash is only kept up to date if there's a table; p_chance
+ *                 is the chance of getting here, and p_fours the number of
+ *                 '4's spawned on the way.
+ */
+
+template<typename B>
+double search_chance( search_t<B> *p_search, const B &p_board, uint64_t p_hash, uint_fast8_t p_depth,
+                      double p_chance, uint_fast8_t p_fours )
+{
+  const search_options_t *l_options = p_search->options;
+  cellmask_t              l_empty = p_board.empty_mask();
+  uint_fast8_t            l_exponents = ( p_fours < l_options->max_fours ) ? 2 : 1;
+  double                  l_total = 0.0, l_weights;
+  B                       l_spawned;
+#if defined( ENGINE_HOST )
+  float                   l_stored;
+  uint64_t                l_key;
+#endif
+
+  if ( search_expired( p_search ) )
+  {
+    return 0.0;
+  }
+  p_search->nodes++;
+
+  if ( p_depth == 0 || l_empty == 0 )
+  {
+    return search_evaluate( p_board );
+  }
+
+  /* Boards we're unlikely ever to see aren't worth searching. */
+  if ( p_chance < l_options->cutoff )
+  {
+    p_search->pruned++;
+    return search_evaluate( p_board );
+  }
+
+  /* We may have been here before, with as many '4's still to come. The */
+  /* value found may have been pruned by a more or less likely path than */
+  /* this one, so what fell under the cutoff can differ; we accept that, */
+  /* as it only ever concerns spawns too unlikely to search.             */
+#if defined( ENGINE_HOST )
+  l_key = search_key( l_options, p_hash, p_depth, p_fours );
+  if ( l_options->table != nullptr && ttable_probe( l_options->table, l_key, p_depth, &l_stored ) )
+  {
+    p_search->table_hits++;
+    return l_stored;
+  }
+#endif
+
+  /* Each spawn is that much less likely than getting here; if '4's are */
+  /* being left out, the '2's stand for all of them.                    */
+  l_weights = ( l_exponents == 2 ) ? 1.0 : SEARCH_TWO_CHANCE;
+  if ( l_exponents == 1 )
+  {
+    p_search->capped += bits_count( l_empty );
+  }
+  p_chance /= bits_count( l_empty );
+
+  /* Deep enough, and with threads to share it, each spawn is a task. */
+#if defined( ENGINE_HOST )
+  if ( l_options->pool != nullptr && p_depth >= SEARCH_SPLIT_DEPTH )
+  {
+    search_task_t<B>  l_tasks[2 * B::cells];
+    uint_fast8_t      l_count = 0;
+
+    for ( cellmask_t l_cells = l_empty; l_cells != 0; l_cells &= l_cells - 1 )
+    {
+      uint_fast8_t l_cell = bits_first( l_cells );
+
+      for ( uint_fast8_t l_exponent = 1; l_exponent <= l_exponents; l_exponent++ )
+      {
+        search_task_t<B> &l_task = l_tasks[l_count++];
+
+        l_task.search = { l_options, 0, 0, 0, 0, false };
+        l_task.board = p_board;
+        l_task.board.set_cell( l_cell / B::width, l_cell % B::width, l_exponent );
+        l_task.hash = board_hash_cell( p_hash, l_cell, 0, l_exponent );
+        l_task.depth = p_depth;
+        l_task.weight = ( l_exponent == 1 ) ? SEARCH_TWO_CHANCE : SEARCH_FOUR_CHANCE;
+        l_task.chance = p_chance * l_task.weight;
+        l_task.fours = p_fours + ( l_exponent - 1 );
+      }
+    }
+
+    search_run_tasks( p_search, search_player_task<B>, l_tasks, l_count );
+    for ( uint_fast8_t l_index = 0; l_index < l_count; l_index++ )
+    {
+      l_total += l_tasks[l_index].weight * l_tasks[l_index].value;
+    }
+  }
+  else
+#endif
+  {
+    for ( cellmask_t l_cells = l_empty; l_cells != 0; l_cells &= l_cells - 1 )
+    {
+      uint_fast8_t l_cell = bits_first( l_cells );
+
+      l_spawned = p_board;
+      l_spawned.set_cell( l_cell / B::width, l_cell % B::width, 1 );
+      l_total += SEARCH_TWO_CHANCE *
+                 search_player( p_search, l_spawned, board_hash_cell( p_hash, l_cell, 0, 1 ), p_depth,
+                                p_chance * SEARCH_TWO_CHANCE, p_fours );
+
+      if ( l_exponents == 2 )
+      {
+        l_spawned.set_cell( l_cell / B::width, l_cell % B::width, 2 );
+        l_total += SEARCH_FOUR_CHANCE *
+                   search_player( p_search, l_spawned, board_hash_cell( p_hash, l_cell, 0, 2 ), p_depth,
+                                  p_chance * SEARCH_FOUR_CHANCE, p_fours + 1 );
+      }
+    }
+  }
+  l_total /= bits_count( l_empty ) * l_weights;
+
+#if defined( ENGINE_HOST )
+  if ( l_options->table != nullptr && !p_search->expired )
+  {
+    ttable_store( l_options->table, l_key, p_depth, (float)l_total );
+  }
+#endif
+  return l_total;
+}
+
+
+/*
+ * search_player - returns the value of the best move from a board, looking
+ *                 p_depth moves ahead; zero if there are no moves left.
+ */
+
+template<typename B>
+double search_player( search_t<B> *p_search, const B &p_board, uint64_t p_hash, uint_fast8_t p_depth,
+                      double p_chance, uint_fast8_t p_fours )
+{
+  uint_fast8_t  l_legal = p_board.legal_moves();
+  double        l_best = 0.0, l_value;
+  B             l_moved;
+
+  /* Out of time, nothing more is worth anything. */
+  if ( search_expired( p_search ) )
+  {
+    return 0.0;
+  }
+  p_search->nodes++;
+
+  for ( uint_fast8_t l_dir = 0; l_dir < DIRECTION_COUNT; l_dir++ )
+  {
+    if ( l_legal & DIRECTION_BIT( l_dir ) )
+    {
+      l_moved = p_board.slide( (direction_t)l_dir );
+      l_value = search_chance( p_search, l_moved,
+                               p_search->options->table ? p_board.rehash( p_hash, l_moved ) : 0,
+                               p_depth - 1, p_chance, p_fours );
+      if ( l_value > l_best )
+      {
+        l_best = l_value;
+      }
+    }
+  }
+
+  return l_best;
+}
+
+
+/*
+ * search_best - searches ahead of the board as the options say (at least
+ *               one move, and no more than TTABLE_MAX_DEPTH), returning the
+ *               best move and its expected value. If there are no legal
+ *               moves, the direction is DIRECTION_COUNT. A transposition
+ *               table, if given, may be reused from search to search; given
+ *               a pool (on the host), the search is shared between its
+ *               threads. If the options' budget runs out first, the result
+ *               is marked incomplete, and shouldn't be trusted. p_hash is
+ *               the board's hash, as a game_t keeps it; it only matters if
+ *               there's a table.
+ */
+
+template<typename B>
+search_result_t search_best( const B &p_board, uint64_t p_hash, const search_options_t *p_options )
+{
+  search_options_t  l_options = *p_options;
+  search_t<B>       l_search = { &l_options, 0, 0, 0, 0, false };
+  search_result_t   l_result = { DIRECTION_COUNT, 0.0, 0, 0, 0, 0, 0, false };
+  uint_fast8_t      l_legal = p_board.legal_moves();
+  search_task_t<B>  l_tasks[DIRECTION_COUNT];
+  direction_t       l_directions[DIRECTION_COUNT];
+  uint_fast8_t      l_count = 0;
+
+  if ( l_options.depth == 0 )
+  {
+    l_options.depth = 1;
+  }
+  if ( l_options.depth > TTABLE_MAX_DEPTH )
+  {
+    l_options.depth = TTABLE_MAX_DEPTH;
+  }
+#if defined( ENGINE_HOST )
+  if ( l_options.table != nullptr )
+  {
+    ttable_age( l_options.table );
+  }
+#endif
+
+  /* Every legal move is a task of its own... */
+  for ( uint_fast8_t l_dir = 0; l_dir < DIRECTION_COUNT; l_dir++ )
+  {
+    if ( l_legal & DIRECTION_BIT( l_dir ) )
+    {
+      search_task_t<B> &l_task = l_tasks[l_count];
+
+      l_task.search = { &l_options, 0, 0, 0, 0, false };
+      l_task.board = p_board.slide( (direction_t)l_dir );
+      l_task.hash = l_options.table ? p_board.rehash( p_hash, l_task.board ) : 0;
+      l_task.depth = l_options.depth - 1;
+      l_task.chance = 1.0;
+      l_task.fours = 0;
+      l_task.weight = 1.0;
+      l_directions[l_count++] = (direction_t)l_dir;
+    }
+  }
+  search_run_tasks( &l_search, search_chance_task<B>, l_tasks, l_count );
+
+  /* ...and the best of them wins. */
+  for ( uint_fast8_t l_index = 0; l_index < l_count; l_index++ )
+  {
+    if ( l_result.direction == DIRECTION_COUNT || l_tasks[l_index].value > l_result.value )
+    {
+      l_result.direction = l_directions[l_index];
+      l_result.value = l_tasks[l_index].value;
+    }
+  }
+
+  l_result.nodes = l_search.nodes + 1;
+  l_result.table_hits = l_search.table_hits;
+  l_result.pruned = l_search.pruned;
+  l_result.capped = l_search.capped;
+  l_result.depth = l_options.depth;
+  l_result.complete = !l_search.expired;
+  return l_result;
+}
+
+
+/*
+ * search_best - searches ahead of a board whose hash isn't to hand; it's
+ *               worked out here, if there's a table to use it.
+ */
+
+template<typename B>
+search_result_t search_best( const B &p_board, const search_options_t *p_options )
+{
+  return search_best( p_board, p_options->table ? p_board.hash() : 0, p_options );
+}
+
+
+/*
+ * search_best - searches p_depth moves ahead of the board with the default
+ *               options, and the given table and pool.
+ */
+
+template<typename B>
+search_result_t search_best( const B &p_board, uint_fast8_t p_depth = SEARCH_DEFAULT_DEPTH,
+                             ttable_t *p_table = nullptr, pool_t *p_pool = nullptr )
+{
+  search_options_t l_options = search_options( p_depth, p_table, p_pool );
+
+  return search_best( p_board, &l_options );
+}
+
+
+/*
+ * search_timed - searches ever deeper, up to the options' depth (or as deep
+ *                as a search can go, if that's zero), until p_budget_us
+ *                microseconds have passed; returns the result of the deepest
+ *                search which finished, with the nodes of every search. A
+ *                one move search always finishes, so there's always a move
+ *                if there's a legal one. p_hash is the board's hash, which
+ *                only matters if there's a table.
+ */
+
+template<typename B>
+search_result_t search_timed( const B &p_board, uint64_t p_hash, const search_options_t *p_options,
+                              uint32_t p_budget_us )
+{
+  search_options_t  l_options = *p_options;
+  uint_fast8_t      l_max = ( p_options->depth > 0 ) ? p_options->depth : TTABLE_MAX_DEPTH;
+  search_result_t   l_result, l_deeper;
+  uint64_t          l_nodes;
+
+  /* The first move is quick, and can't be left unfinished. */
+  l_options.start_us = platform_time_us();
+  l_options.budget_us = 0;
+  l_options.depth = 1;
+  l_result = search_best( p_board, p_hash, &l_options );
+  l_nodes = l_result.nodes;
+
+  /* With nothing to choose between, there's no more to do. */
+  if ( bits_count( p_board.legal_moves() ) <= 1 )
+  {
+    return l_result;
+  }
+
+  /* Then deeper and deeper, until the time runs out. */
+  l_options.budget_us = p_budget_us;
+  while( l_options.depth < l_max &&
+         (uint32_t)( platform_time_us() - l_options.start_us ) < p_budget_us )
+  {
+    l_options.depth++;
+    l_deeper = search_best( p_board, p_hash, &l_options );
+    l_nodes += l_deeper.nodes;
+    if ( !l_deeper.complete )
+    {
+      break;
+    }
+    l_result = l_deeper;
+  }
+
+  l_result.nodes = l_nodes;
+  return l_result;
+}
+
+
+/*
+ * search_timed - searches ahead of a board whose hash isn't to hand, until
+ *                the budget runs out; the hash is worked out here, if there
+ *                is a table to use it.
+ */
+
+template<typename B>
+search_result_t search_timed( const B &p_board, const search_options_t *p_options, uint32_t p_budget_us )
+{
+  return search_timed( p_board, p_options->table ? p_board.hash() : 0, p_options, p_budget_us );
+}
+
+#endif /* _ENGINE_SEARCH_HPP_ */
+
+/* End of file engine/search.hpp */
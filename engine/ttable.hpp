@@ -0,0 +1,172 @@
+/*
+ * engine/ttable.hpp; a transposition table for the search, shared between
+ * threads without any locks.
+ *
+ * Expectimax reaches the same position again and again, by spawning the
+ * same tiles in a different order, so the value worked out for a position
+ * is kept against its Zobrist hash. The table is a power-of-two array of
+ * 64-bit entries, each packed as:
+ *
+ *   63..40  the top 24 bits of the hash, to check it's the right position
+ *   39..36  the generation (search) which stored it
+ *   35..32  the depth it was searched to
+ *   31..0   the value, as a float
+ *
+ * Whole entries are read and written atomically, so threads sharing the
+ * table never see half of one; a store only replaces an entry searched to
+ * a lesser depth, or one left over from an earlier search, and uses a
+ * compare-and-swap so a deeper entry stored meanwhile by another thread
+ * is never lost. An empty entry has a depth of zero, which is never used.
+ *
+ * Like the thread pool, the table is only for host builds; the PicoSystem's
+ * Cortex-M0+ has no 64-bit atomics, and a compare-and-swap on one would
+ * need library support the SDK doesn't promise. Device searches simply go
+ * without, so only the type is declared there.
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+#ifndef _ENGINE_TTABLE_HPP_
+#define _ENGINE_TTABLE_HPP_
+
+/* System headers. */
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+
+/* Constants. */
+
+#define TTABLE_DEFAULT_BITS     22
+#define TTABLE_MAX_DEPTH        15
+#define TTABLE_GENERATIONS      16
+
+#define TTABLE_TAG( h )         ( ( h ) & 0xFFFFFF0000000000ull )
+#define TTABLE_ENTRY_TAG( e )   ( ( e ) & 0xFFFFFF0000000000ull )
+#define TTABLE_ENTRY_GEN( e )   ( ( ( e ) >> 36 ) & 0x0F )
+#define TTABLE_ENTRY_DEPTH( e ) ( ( ( e ) >> 32 ) & 0x0F )
+
+
+/* Local structures and types. */
+
+typedef struct
+{
+  std::atomic<uint64_t> *entries;
+  uint64_t               mask;
+  uint_fast8_t           generation;
+} ttable_t;
+
+
+/* Functions. */
+
+#if defined( ENGINE_HOST )
+
+/*
+ * ttable_create - allocates an empty table of 2^p_bits entries; returns
+ *                 nullptr if there isn't the memory for it.
+ */
+
+inline ttable_t *ttable_create( uint_fast8_t p_bits = TTABLE_DEFAULT_BITS )
+{
+  ttable_t *l_table = new ttable_t;
+
+  l_table->mask = ( (uint64_t)1 << p_bits ) - 1;
+  l_table->generation = 0;
+  l_table->entries = new ( std::nothrow ) std::atomic<uint64_t>[l_table->mask + 1];
+  if ( l_table->entries == nullptr )
+  {
+    delete l_table;
+    return nullptr;
+  }
+
+  for ( uint64_t l_index = 0; l_index <= l_table->mask; l_index++ )
+  {
+    l_table->entries[l_index].store( 0, std::memory_order_relaxed );
+  }
+  return l_table;
+}
+
+
+/*
+ * ttable_destroy - frees a table.
+ */
+
+inline void ttable_destroy( ttable_t *p_table )
+{
+  if ( p_table != nullptr )
+  {
+    delete[] p_table->entries;
+    delete p_table;
+  }
+}
+
+
+/*
+ * ttable_age - starts a new generation; called before each search (and not
+ *              during one), so that entries from earlier searches, which
+ *              are still correct but less likely to be needed, give way.
+ */
+
+inline void ttable_age( ttable_t *p_table )
+{
+  p_table->generation = ( p_table->generation + 1 ) % TTABLE_GENERATIONS;
+}
+
+
+/*
+ * ttable_probe - looks for the position with the given hash, searched to
+ *                at least p_depth; if it's there, sets p_value and returns
+ *                true.
+ */
+
+inline bool ttable_probe( const ttable_t *p_table, uint64_t p_hash, uint_fast8_t p_depth, float *p_value )
+{
+  uint64_t l_entry = p_table->entries[p_hash & p_table->mask].load( std::memory_order_relaxed );
+  uint32_t l_bits;
+
+  if ( TTABLE_ENTRY_TAG( l_entry ) != TTABLE_TAG( p_hash ) || TTABLE_ENTRY_DEPTH( l_entry ) < p_depth ||
+       TTABLE_ENTRY_DEPTH( l_entry ) == 0 )
+  {
+    return false;
+  }
+
+  l_bits = (uint32_t)l_entry;
+  memcpy( p_value, &l_bits, sizeof( float ) );
+  return true;
+}
+
+
+/*
+ * ttable_store - records the value of a position searched to p_depth (from
+ *                1 to TTABLE_MAX_DEPTH), unless its slot holds something
+ *                more valuable from this search.
+ */
+
+inline void ttable_store( ttable_t *p_table, uint64_t p_hash, uint_fast8_t p_depth, float p_value )
+{
+  std::atomic<uint64_t> &l_slot = p_table->entries[p_hash & p_table->mask];
+  uint64_t               l_entry, l_old;
+  uint32_t               l_bits;
+
+  memcpy( &l_bits, &p_value, sizeof( float ) );
+  l_entry = TTABLE_TAG( p_hash ) | ( (uint64_t)p_table->generation << 36 ) | ( (uint64_t)p_depth << 32 ) | l_bits;
+
+  /* Another thread may get in first; if so, decide again against that. */
+  l_old = l_slot.load( std::memory_order_relaxed );
+  do
+  {
+    if ( TTABLE_ENTRY_GEN( l_old ) == p_table->generation && TTABLE_ENTRY_DEPTH( l_old ) > p_depth )
+    {
+      return;
+    }
+  } while( !l_slot.compare_exchange_weak( l_old, l_entry, std::memory_order_relaxed ) );
+}
+
+#endif /* ENGINE_HOST */
+
+#endif /* _ENGINE_TTABLE_HPP_ */
+
+/* End of file engine/ttable.hpp */
@@ -0,0 +1,346 @@
+/*
+ * host/picosystem.cpp; a headless stand-in for the PicoSystem SDK.
+ *
+ * Colours are the SDK's packed 4-bit RGBA (green, blue, alpha and red from
+ * the top nibble down), and drawing blends each source pixel over the
+ * framebuffer by its alpha, which is close enough to the real blender for
+ * the cost of a frame to be representative. Everything is clipped to the
+ * screen.
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+/* System headers. */
+
+#include <cstdint>
+
+
+/* Local headers. */
+
+#include "picosystem.hpp"
+
+
+/* Module variables. */
+
+static picosystem::color_t  g_host_pixels[HOST_SCREEN_WIDTH * HOST_SCREEN_HEIGHT];
+static picosystem::buffer_t g_host_screen = { HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT, g_host_pixels };
+static picosystem::color_t  g_host_pen;
+static uint32_t             g_host_time_us;
+static uint32_t             g_host_audio_until_us;
+static uint32_t             g_host_sounds;
+static uint32_t             g_host_held, g_host_io, g_host_last_io;
+
+picosystem::buffer_t       *picosystem::SCREEN = &g_host_screen;
+
+
+/* Functions. */
+
+/*
+ * host_blend - blends a run of p_count source pixels over the destination,
+ *              stepping through the source p_step pixels at a time (zero
+ *              repeats the same pixel, as the pen does).
+ */
+
+static void host_blend( const picosystem::color_t *p_src, int32_t p_step,
+                        picosystem::color_t *p_dest, int32_t p_count )
+{
+  for ( ; p_count > 0; p_count--, p_src += p_step, p_dest++ )
+  {
+    uint_fast16_t l_src = *p_src, l_dest = *p_dest, l_result;
+    uint_fast8_t  l_alpha = ( l_src >> 4 ) & 0x0F;
+
+    /* Transparent and opaque pixels are the common cases. */
+    if ( l_alpha == 0 )
+    {
+      continue;
+    }
+    if ( l_alpha == 0x0F )
+    {
+      *p_dest = l_src;
+      continue;
+    }
+
+    /* Otherwise, move each colour channel part way towards the source; */
+    /* the destination keeps its own alpha.                             */
+    l_result = l_dest & 0x00F0;
+    for ( uint_fast8_t l_shift = 0; l_shift < 16; l_shift += 4 )
+    {
+      int_fast16_t l_from, l_to;
+
+      if ( l_shift == 4 )
+      {
+        continue;
+      }
+      l_from = ( l_dest >> l_shift ) & 0x0F;
+      l_to = ( l_src >> l_shift ) & 0x0F;
+      l_result |= (uint_fast16_t)( l_from + ( ( l_to - l_from ) * l_alpha ) / 16 ) << l_shift;
+    }
+    *p_dest = l_result;
+  }
+}
+
+
+/*
+ * host_span - fills part of one row of the screen with the pen, clipped.
+ */
+
+static void host_span( int32_t p_x, int32_t p_y, int32_t p_count )
+{
+  if ( p_y < 0 || p_y >= picosystem::SCREEN->h )
+  {
+    return;
+  }
+  if ( p_x < 0 )
+  {
+    p_count += p_x;
+    p_x = 0;
+  }
+  if ( p_x + p_count > picosystem::SCREEN->w )
+  {
+    p_count = picosystem::SCREEN->w - p_x;
+  }
+  if ( p_count > 0 )
+  {
+    host_blend( &g_host_pen, 0, picosystem::SCREEN->p( p_x, p_y ), p_count );
+  }
+}
+
+
+/*
+ * pen - sets the colour for the drawing functions; each channel is 0-15.
+ */
+
+void picosystem::pen( uint8_t r, uint8_t g, uint8_t b, uint8_t a )
+{
+  g_host_pen = ( r & 0x0F ) | ( ( a & 0x0F ) << 4 ) | ( ( b & 0x0F ) << 8 ) | ( ( g & 0x0F ) << 12 );
+}
+
+
+/*
+ * clear - fills the whole screen with the pen.
+ */
+
+void picosystem::clear( void )
+{
+  frect( 0, 0, SCREEN->w, SCREEN->h );
+}
+
+
+/*
+ * pixel - plots a single pixel in the pen.
+ */
+
+void picosystem::pixel( int32_t x, int32_t y )
+{
+  host_span( x, y, 1 );
+}
+
+
+/*
+ * hline - draws a horizontal line c pixels long.
+ */
+
+void picosystem::hline( int32_t x, int32_t y, int32_t c )
+{
+  host_span( x, y, c );
+}
+
+
+/*
+ * vline - draws a vertical line c pixels long.
+ */
+
+void picosystem::vline( int32_t x, int32_t y, int32_t c )
+{
+  for ( int32_t l_y = y; l_y < y + c; l_y++ )
+  {
+    host_span( x, l_y, 1 );
+  }
+}
+
+
+/*
+ * frect - fills a rectangle.
+ */
+
+void picosystem::frect( int32_t x, int32_t y, int32_t w, int32_t h )
+{
+  for ( int32_t l_y = y; l_y < y + h; l_y++ )
+  {
+    host_span( x, l_y, w );
+  }
+}
+
+
+/*
+ * blit - copies a rectangle of the source buffer onto the screen at the
+ *        same size.
+ */
+
+void picosystem::blit( buffer_t *src, int32_t x, int32_t y, int32_t w, int32_t h,
+                       int32_t dx, int32_t dy, uint32_t flags )
+{
+  blit( src, x, y, w, h, dx, dy, w, h, flags );
+}
+
+
+/*
+ * blit - copies a rectangle of the source buffer onto the screen, scaled
+ *        to dw x dh by picking the nearest source pixel. Unscaled, unflipped
+ *        rows are blended straight across.
+ */
+
+void picosystem::blit( buffer_t *src, int32_t x, int32_t y, int32_t w, int32_t h,
+                       int32_t dx, int32_t dy, int32_t dw, int32_t dh, uint32_t flags )
+{
+  int32_t l_left = ( dx < 0 ) ? -dx : 0;
+  int32_t l_right = ( dx + dw > SCREEN->w ) ? SCREEN->w - dx : dw;
+
+  if ( dw <= 0 || dh <= 0 || l_left >= l_right )
+  {
+    return;
+  }
+
+  for ( int32_t l_row = ( dy < 0 ) ? -dy : 0; l_row < dh && dy + l_row < SCREEN->h; l_row++ )
+  {
+    int32_t  l_src_y = ( l_row * h ) / dh;
+    color_t *l_dest = SCREEN->p( dx + l_left, dy + l_row );
+
+    if ( flags & VFLIP )
+    {
+      l_src_y = h - 1 - l_src_y;
+    }
+
+    /* The straight copy is the one the game mostly uses. */
+    if ( dw == w && ( flags & HFLIP ) == 0 )
+    {
+      host_blend( src->p( x + l_left, y + l_src_y ), 1, l_dest, l_right - l_left );
+      continue;
+    }
+
+    for ( int32_t l_col = l_left; l_col < l_right; l_col++, l_dest++ )
+    {
+      int32_t l_src_x = ( l_col * w ) / dw;
+
+      if ( flags & HFLIP )
+      {
+        l_src_x = w - 1 - l_src_x;
+      }
+      host_blend( src->p( x + l_src_x, y + l_src_y ), 0, l_dest, 1 );
+    }
+  }
+}
+
+
+/*
+ * voice - describes an instrument; the host keeps it, but never uses it.
+ */
+
+picosystem::voice_t picosystem::voice( uint32_t attack, uint32_t decay, uint32_t sustain,
+                                       uint32_t release, int32_t bend, uint32_t bend_ms,
+                                       uint32_t reverb, uint32_t noise, uint32_t distort )
+{
+  return { attack, decay, sustain, release, bend, bend_ms, reverb, noise, distort };
+}
+
+
+/*
+ * play - "plays" a note; silently, but it keeps the audio busy for its
+ *        duration (in milliseconds) on the virtual clock.
+ */
+
+void picosystem::play( voice_t voice, uint32_t frequency, uint32_t duration, uint32_t volume )
+{
+  (void)voice;
+  (void)frequency;
+  (void)volume;
+
+  g_host_audio_until_us = g_host_time_us + duration * 1000;
+  g_host_sounds++;
+}
+
+
+/*
+ * audio_playing - returns true if the last note is still sounding.
+ */
+
+bool picosystem::audio_playing( void )
+{
+  return (int32_t)( g_host_audio_until_us - g_host_time_us ) > 0;
+}
+
+
+/*
+ * pressed - returns true if the button went down since the last tick.
+ */
+
+bool picosystem::pressed( uint32_t b )
+{
+  return ( g_host_io & ~g_host_last_io & ( 1u << b ) ) != 0;
+}
+
+
+/*
+ * time_us - returns the virtual clock, in microseconds.
+ */
+
+uint32_t picosystem::time_us( void )
+{
+  return g_host_time_us;
+}
+
+
+/*
+ * host_reset - puts the screen, clock, audio and buttons back as they
+ *              were at power on.
+ */
+
+void host_reset( void )
+{
+  for ( picosystem::color_t &l_pixel : g_host_pixels )
+  {
+    l_pixel = 0;
+  }
+  g_host_pen = 0;
+  g_host_time_us = g_host_audio_until_us = 0;
+  g_host_sounds = 0;
+  g_host_held = g_host_io = g_host_last_io = 0;
+}
+
+
+/*
+ * host_buttons - sets which buttons are being held down, as a mask of
+ *                ( 1 << picosystem::button ); read at the next tick.
+ */
+
+void host_buttons( uint32_t p_held )
+{
+  g_host_held = p_held;
+}
+
+
+/*
+ * host_tick - moves the virtual clock on, and samples the buttons; called
+ *             before each update(), as the SDK's main loop would.
+ */
+
+void host_tick( uint32_t p_elapsed_us )
+{
+  g_host_time_us += p_elapsed_us;
+  g_host_last_io = g_host_io;
+  g_host_io = g_host_held;
+}
+
+
+/*
+ * host_sounds - returns how many notes have been played since the reset.
+ */
+
+uint32_t host_sounds( void )
+{
+  return g_host_sounds;
+}
+
+
+/* End of file host/picosystem.cpp */
@@ -0,0 +1,99 @@
+/*
+ * host/picosystem.hpp; a headless stand-in for the PicoSystem SDK.
+ *
+ * Provides just the parts of the picosystem:: API that the game uses, so
+ * that 2040-eight.cpp builds unchanged on the host. Drawing goes into an
+ * in-memory 240x240 framebuffer, using the SDK's 4-bit RGBA colours and
+ * alpha blending, and time comes from a virtual clock which only moves
+ * when told to; nothing is ever shown, or heard.
+ *
+ * The host_ functions play the part of the SDK's main loop, advancing the
+ * clock and feeding in the buttons, so a tool can drive init(), update()
+ * and draw() itself and time each of them.
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+#ifndef _HOST_PICOSYSTEM_HPP_
+#define _HOST_PICOSYSTEM_HPP_
+
+/* System headers. */
+
+#include <cstdint>
+
+
+/* Constants. */
+
+#define HOST_SCREEN_WIDTH   240
+#define HOST_SCREEN_HEIGHT  240
+
+
+/* Local structures and types. */
+
+namespace picosystem
+{
+  typedef uint16_t color_t;
+
+  struct buffer_t
+  {
+    int32_t   w, h;
+    color_t  *data;
+
+    color_t *p( int32_t x, int32_t y ) { return data + x + y * w; }
+  };
+
+  struct voice_t
+  {
+    uint32_t  attack, decay, sustain, release;
+    int32_t   bend;
+    uint32_t  bend_ms, reverb, noise, distort;
+  };
+
+  enum button { UP = 23, DOWN = 20, LEFT = 22, RIGHT = 21, A = 18, B = 19, X = 17, Y = 16 };
+  enum blit_flags { HFLIP = 0x01, VFLIP = 0x02 };
+
+  extern buffer_t *SCREEN;
+
+
+  /* Functions. */
+
+  void      pen( uint8_t r, uint8_t g, uint8_t b, uint8_t a = 15 );
+  void      clear( void );
+  void      pixel( int32_t x, int32_t y );
+  void      hline( int32_t x, int32_t y, int32_t c );
+  void      vline( int32_t x, int32_t y, int32_t c );
+  void      frect( int32_t x, int32_t y, int32_t w, int32_t h );
+  void      blit( buffer_t *src, int32_t x, int32_t y, int32_t w, int32_t h,
+                  int32_t dx, int32_t dy, uint32_t flags = 0 );
+  void      blit( buffer_t *src, int32_t x, int32_t y, int32_t w, int32_t h,
+                  int32_t dx, int32_t dy, int32_t dw, int32_t dh, uint32_t flags = 0 );
+
+  voice_t   voice( uint32_t attack = 100, uint32_t decay = 50, uint32_t sustain = 80,
+                   uint32_t release = 100, int32_t bend = 0, uint32_t bend_ms = 0,
+                   uint32_t reverb = 0, uint32_t noise = 0, uint32_t distort = 0 );
+  void      play( voice_t voice, uint32_t frequency, uint32_t duration = 500, uint32_t volume = 100 );
+  bool      audio_playing( void );
+
+  bool      pressed( uint32_t b );
+  uint32_t  time_us( void );
+}
+
+
+/* The game's own entry points, as the SDK expects them. */
+
+void init( void );
+void update( uint32_t p_tick );
+void draw( uint32_t p_tick );
+
+
+/* Functions in picosystem.cpp, standing in for the SDK's main loop. */
+
+void      host_reset( void );
+void      host_buttons( uint32_t p_held );
+void      host_tick( uint32_t p_elapsed_us );
+uint32_t  host_sounds( void );
+
+#endif /* _HOST_PICOSYSTEM_HPP_ */
+
+/* End of file host/picosystem.hpp */
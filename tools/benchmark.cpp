@@ -0,0 +1,539 @@
+/*
+ * tools/benchmark.cpp; measures the move engine's throughput on the host.
+ *
+ * Compares the standard 4-bit exponent 4x4 board against the 5-bit mode,
+ * both on raw moves (every direction, over a pool of realistic boards) and
+ * on complete random games, where spawning and legality checks count too.
+ * The 5-bit board's raw moves are timed again with a tile of 2^15 or more
+ * in every row, which is where it can no longer borrow the 4-bit tables.
+ *
+ * The bulk moves are then checked against Board::slide(), over the same
+ * pool of 4x4 boards, and timed against it; a kernel that disagrees with
+ * slide() for any board fails the benchmark. The bitsliced kernel is timed
+ * on boards already packed into planes, as they're meant to be kept; the
+ * packing is timed separately.
+ *
+ * Before any of that, boards of each shape are checked against what they
+ * promise: every symmetric form of a board has the same canonical() one,
+ * which transform() reproduces as canonical() says it does; and the hash a
+ * game keeps cell by cell through its spawns and moves is always the one
+ * hash() works out from scratch.
+ *
+ * Usage: benchmark [rounds]
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+/* System headers. */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+
+/* Local headers. */
+
+#include "engine/batch.hpp"
+#include "engine/bitslice.hpp"
+#include "engine/board.hpp"
+#include "engine/game.hpp"
+#include "engine/platform.hpp"
+#include "engine/rng.hpp"
+
+
+/* Constants. */
+
+#define BENCH_POOL_SIZE         4096
+#define BENCH_DEFAULT_ROUNDS    2000
+#define BENCH_GAMES_PER_ROUND   2
+#define BENCH_SEED              0x2040
+#define BENCH_CHECK_BOARDS      512
+#define BENCH_CHECK_GAMES       64
+
+
+/* Local structures and types. */
+
+typedef struct
+{
+  double    moves_per_second;
+  double    games_per_second;
+  uint64_t  checksum;
+} bench_result_t;
+
+typedef struct
+{
+  double    scalar_ns;
+  double    batch_ns;
+  double    pack_ns;
+  bool      matched;
+} bench_bulk_t;
+
+
+/* Functions. */
+
+/*
+ * bench_seconds - returns the seconds elapsed since p_start_us.
+ */
+
+static double bench_seconds( uint64_t p_start_us )
+{
+  return ( platform_time_us() - p_start_us ) / 1000000.0;
+}
+
+
+/*
+ * bench_play - plays one game to the end from the given seed, choosing
+ *              moves at random, returning the number of moves made; the
+ *              score is added to p_score.
+ */
+
+template<typename B>
+static uint32_t bench_play( uint64_t p_seed, rng_t *p_rng, uint64_t *p_score )
+{
+  game_t<B>     l_game;
+  uint_fast8_t  l_direction;
+
+  game_reset( &l_game, p_seed );
+  while( game_spawn( &l_game ) && ( l_game.legal != 0 ) )
+  {
+    l_direction = bits_select( l_game.legal, rng_below( p_rng, bits_count( l_game.legal ) ) );
+    game_move( &l_game, (direction_t)l_direction );
+  }
+
+  *p_score += l_game.score;
+  return l_game.moves;
+}
+
+
+/*
+ * bench_pool - fills a pool with boards like those seen mid-game; mostly
+ *              small tiles, with around a third of the cells empty. With
+ *              p_big, every row also gets one tile of 32768 or more, as
+ *              the long runs 5-bit boards are for will have.
+ */
+
+template<typename B>
+static std::vector<B> bench_pool( bool p_big = false )
+{
+  std::vector<B>  l_pool( BENCH_POOL_SIZE );
+  rng_t           l_rng;
+
+  rng_seed( &l_rng, BENCH_SEED );
+  for ( B &l_board : l_pool )
+  {
+    for ( uint_fast8_t l_cell = 0; l_cell < B::cells; l_cell++ )
+    {
+      uint_fast8_t l_exponent = ( rng_below( &l_rng, 3 ) == 0 ) ? 0 : 1 + rng_below( &l_rng, 11 );
+      l_board.set_cell( l_cell / B::width, l_cell % B::width, l_exponent );
+    }
+    for ( uint_fast8_t l_row = 0; p_big && l_row < B::height; l_row++ )
+    {
+      l_board.set_cell( l_row, rng_below( &l_rng, B::width ), 15 + rng_below( &l_rng, B::max_exponent - 14 ) );
+    }
+  }
+
+  return l_pool;
+}
+
+
+/*
+ * bench_check_symmetry - checks every transform() of a pool of boards, cell
+ *                        by cell against where each symmetry should move
+ *                        them, and that all of them share one canonical()
+ *                        which transform() reproduces; true if they do.
+ */
+
+template<typename B>
+static bool bench_check_symmetry( void )
+{
+  constexpr uint_fast8_t  l_count = ( B::width == B::height ) ? BOARD_SYMMETRIES : BOARD_SYMMETRIES / 2;
+  std::vector<B>          l_pool = bench_pool<B>();
+  uint_fast8_t            l_symmetry;
+
+  l_pool.resize( BENCH_CHECK_BOARDS );
+  for ( const B &l_board : l_pool )
+  {
+    B l_canonical = l_board.canonical( &l_symmetry );
+
+    if ( !( l_board.transform( l_symmetry ) == l_canonical ) )
+    {
+      return false;
+    }
+
+    for ( uint_fast8_t l_form = 0; l_form < l_count; l_form++ )
+    {
+      B l_transformed = l_board.transform( l_form );
+
+      /* Mirror, then flip, then transpose; a cell at a time. */
+      for ( uint_fast8_t l_row = 0; l_row < B::height; l_row++ )
+      {
+        for ( uint_fast8_t l_col = 0; l_col < B::width; l_col++ )
+        {
+          uint_fast8_t l_to_row = ( l_form & BOARD_SYMMETRY_FLIP ) ? B::height - 1 - l_row : l_row;
+          uint_fast8_t l_to_col = ( l_form & BOARD_SYMMETRY_MIRROR ) ? B::width - 1 - l_col : l_col;
+
+          if ( l_form & BOARD_SYMMETRY_TRANSPOSE )
+          {
+            uint_fast8_t l_swap = l_to_row;
+            l_to_row = l_to_col;
+            l_to_col = l_swap;
+          }
+          if ( l_transformed.cell( l_to_row, l_to_col ) != l_board.cell( l_row, l_col ) )
+          {
+            return false;
+          }
+        }
+      }
+
+      if ( !( l_transformed.canonical() == l_canonical ) )
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+
+/*
+ * bench_check_hashes - plays random games, checking after every spawn and
+ *                      move that the hash the game has kept up to date is
+ *                      the board's hash worked out afresh; true if it is.
+ */
+
+template<typename B>
+static bool bench_check_hashes( void )
+{
+  game_t<B>     l_game;
+  rng_t         l_rng;
+  uint_fast8_t  l_direction;
+
+  rng_seed( &l_rng, BENCH_SEED );
+  for ( uint32_t l_index = 0; l_index < BENCH_CHECK_GAMES; l_index++ )
+  {
+    game_reset( &l_game, BENCH_SEED + l_index );
+    while( game_spawn( &l_game ) )
+    {
+      if ( l_game.hash != l_game.board.hash() )
+      {
+        return false;
+      }
+      if ( l_game.legal == 0 )
+      {
+        break;
+      }
+
+      l_direction = bits_select( l_game.legal, rng_below( &l_rng, bits_count( l_game.legal ) ) );
+      game_move( &l_game, (direction_t)l_direction );
+      if ( l_game.hash != l_game.board.hash() )
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+
+/*
+ * bench_check - runs the symmetry and hash checks for one board type,
+ *               reporting any failure; true if everything passed.
+ */
+
+template<typename B>
+static bool bench_check( const char *p_name )
+{
+  bool l_passed = true;
+
+  if ( !bench_check_symmetry<B>() )
+  {
+    fprintf( stderr, "%s: symmetries don't agree on a canonical board\n", p_name );
+    l_passed = false;
+  }
+  if ( !bench_check_hashes<B>() )
+  {
+    fprintf( stderr, "%s: a game's hash drifted from its board's\n", p_name );
+    l_passed = false;
+  }
+
+  return l_passed;
+}
+
+
+/*
+ * bench_moves - times raw moves over a pool; every board, every direction,
+ *               every round. Returns the moves per second, and adds what
+ *               the moves made to p_checksum.
+ */
+
+template<typename B>
+static double bench_moves( uint32_t p_rounds, const std::vector<B> &p_pool, uint64_t *p_checksum )
+{
+  uint64_t l_moves = 0, l_start = platform_time_us();
+
+  for ( uint32_t l_round = 0; l_round < p_rounds; l_round++ )
+  {
+    for ( const B &l_board : p_pool )
+    {
+      for ( uint_fast8_t l_dir = 0; l_dir < DIRECTION_COUNT; l_dir++ )
+      {
+        move_result_t<B> l_moved = l_board.move( (direction_t)l_dir );
+        *p_checksum += l_moved.empty + l_moved.score + l_moved.board.m_words[0];
+        l_moves++;
+      }
+    }
+  }
+
+  return l_moves / bench_seconds( l_start );
+}
+
+
+/*
+ * bench_run - times both halves of the benchmark for one board type.
+ */
+
+template<typename B>
+static bench_result_t bench_run( uint32_t p_rounds )
+{
+  bench_result_t  l_result = {};
+  rng_t           l_rng;
+  uint64_t        l_games = 0, l_start;
+
+  /* Raw moves... */
+  l_result.moves_per_second = bench_moves( p_rounds, bench_pool<B>(), &l_result.checksum );
+
+  /* ...and whole random games. */
+  rng_seed( &l_rng, BENCH_SEED );
+  l_start = platform_time_us();
+  for ( uint32_t l_round = 0; l_round < p_rounds * BENCH_GAMES_PER_ROUND; l_round++ )
+  {
+    l_result.checksum += bench_play<B>( BENCH_SEED + l_round, &l_rng, &l_result.checksum );
+    l_games++;
+  }
+  l_result.games_per_second = l_games / bench_seconds( l_start );
+
+  return l_result;
+}
+
+
+/*
+ * bench_scalar_ns - times Board::slide() over the pool, in every direction,
+ *                   returning the nanoseconds per board moved.
+ */
+
+static double bench_scalar_ns( uint32_t p_rounds, const std::vector<Board<4, 4>> &p_pool )
+{
+  std::vector<Board<4, 4>>  l_out( p_pool.size() );
+  uint64_t                  l_start = platform_time_us();
+
+  for ( uint32_t l_round = 0; l_round < p_rounds; l_round++ )
+  {
+    for ( uint_fast8_t l_dir = 0; l_dir < DIRECTION_COUNT; l_dir++ )
+    {
+      for ( size_t l_index = 0; l_index < p_pool.size(); l_index++ )
+      {
+        l_out[l_index] = p_pool[l_index].slide( (direction_t)l_dir );
+      }
+    }
+  }
+
+  return 1000.0 * ( platform_time_us() - l_start ) / ( (uint64_t)p_rounds * DIRECTION_COUNT * p_pool.size() );
+}
+
+
+/*
+ * bench_bulk - checks a bulk move kernel against Board::slide() on every
+ *              board in the pool, in every direction, and then times the
+ *              two of them over the pool; p_move slides p_count boards
+ *              from p_in into p_out.
+ */
+
+template<typename F>
+static bench_bulk_t bench_bulk( uint32_t p_rounds, F p_move )
+{
+  typedef Board<4, 4> board_t;
+
+  bench_bulk_t          l_result = { 0.0, 0.0, 0.0, true };
+  std::vector<board_t>  l_pool = bench_pool<board_t>();
+  std::vector<board_t>  l_out( l_pool.size() );
+  uint64_t              l_start, l_boards = (uint64_t)p_rounds * DIRECTION_COUNT * l_pool.size();
+
+  /* It has to get the same answers first, or the speed means nothing. */
+  for ( uint_fast8_t l_dir = 0; l_dir < DIRECTION_COUNT; l_dir++ )
+  {
+    p_move( (direction_t)l_dir, l_pool.data(), l_out.data(), l_pool.size() );
+    for ( size_t l_index = 0; l_index < l_pool.size(); l_index++ )
+    {
+      l_result.matched &= ( l_out[l_index] == l_pool[l_index].slide( (direction_t)l_dir ) );
+    }
+  }
+
+  /* Then one board at a time... */
+  l_result.scalar_ns = bench_scalar_ns( p_rounds, l_pool );
+
+  /* ...and in bulk. */
+  l_start = platform_time_us();
+  for ( uint32_t l_round = 0; l_round < p_rounds; l_round++ )
+  {
+    for ( uint_fast8_t l_dir = 0; l_dir < DIRECTION_COUNT; l_dir++ )
+    {
+      p_move( (direction_t)l_dir, l_pool.data(), l_out.data(), l_pool.size() );
+    }
+  }
+  l_result.batch_ns = 1000.0 * ( platform_time_us() - l_start ) / l_boards;
+
+  return l_result;
+}
+
+
+/*
+ * bench_bitslice - checks the bitsliced kernel against Board::slide() on
+ *                  every board in the pool, in every direction, and times
+ *                  it on the pool kept packed in wide planes; packing and
+ *                  unpacking are timed on their own.
+ */
+
+static bench_bulk_t bench_bitslice( uint32_t p_rounds )
+{
+  typedef Board<4, 4> board_t;
+  const size_t l_sets = BENCH_POOL_SIZE / ( BITSLICE_BOARDS * BITSLICE_LANES );
+
+  bench_bulk_t                  l_result = { 0.0, 0.0, 0.0, true };
+  std::vector<board_t>          l_pool = bench_pool<board_t>();
+  std::vector<board_t>          l_out( l_pool.size() );
+  std::vector<bitslice_wide_t>  l_slices( l_sets );
+  uint64_t                      l_start, l_boards = (uint64_t)p_rounds * DIRECTION_COUNT * l_pool.size();
+
+  static_assert( BENCH_POOL_SIZE % ( BITSLICE_BOARDS * BITSLICE_LANES ) == 0, "the pool must pack into whole sets" );
+
+  /* Check every direction, from freshly packed planes each time. */
+  for ( uint_fast8_t l_dir = 0; l_dir < DIRECTION_COUNT; l_dir++ )
+  {
+    for ( size_t l_set = 0; l_set < l_sets; l_set++ )
+    {
+      bitslice_pack_wide( &l_pool[l_set * BITSLICE_BOARDS * BITSLICE_LANES], &l_slices[l_set] );
+      bitslice_move( l_slices[l_set].plane, (direction_t)l_dir );
+      bitslice_unpack_wide( &l_slices[l_set], &l_out[l_set * BITSLICE_BOARDS * BITSLICE_LANES] );
+    }
+    for ( size_t l_index = 0; l_index < l_pool.size(); l_index++ )
+    {
+      l_result.matched &= ( l_out[l_index] == l_pool[l_index].slide( (direction_t)l_dir ) );
+    }
+  }
+
+  l_result.scalar_ns = bench_scalar_ns( p_rounds, l_pool );
+
+  /* The moves themselves, on planes which stay packed throughout. */
+  for ( size_t l_set = 0; l_set < l_sets; l_set++ )
+  {
+    bitslice_pack_wide( &l_pool[l_set * BITSLICE_BOARDS * BITSLICE_LANES], &l_slices[l_set] );
+  }
+  l_start = platform_time_us();
+  for ( uint32_t l_round = 0; l_round < p_rounds; l_round++ )
+  {
+    for ( uint_fast8_t l_dir = 0; l_dir < DIRECTION_COUNT; l_dir++ )
+    {
+      for ( bitslice_wide_t &l_slice : l_slices )
+      {
+        bitslice_move( l_slice.plane, (direction_t)l_dir );
+      }
+    }
+  }
+  l_result.batch_ns = 1000.0 * ( platform_time_us() - l_start ) / l_boards;
+
+  /* And the cost of getting boards in and out of the planes. */
+  l_start = platform_time_us();
+  for ( uint32_t l_round = 0; l_round < p_rounds; l_round++ )
+  {
+    for ( size_t l_set = 0; l_set < l_sets; l_set++ )
+    {
+      bitslice_pack_wide( &l_pool[l_set * BITSLICE_BOARDS * BITSLICE_LANES], &l_slices[l_set] );
+      bitslice_unpack_wide( &l_slices[l_set], &l_out[l_set * BITSLICE_BOARDS * BITSLICE_LANES] );
+    }
+  }
+  l_result.pack_ns = 1000.0 * ( platform_time_us() - l_start ) / ( (uint64_t)p_rounds * l_pool.size() );
+
+  return l_result;
+}
+
+
+/*
+ * bench_report - prints one line of the bulk move results.
+ */
+
+static void bench_report( const char *p_name, const bench_bulk_t *p_bulk )
+{
+  printf( "%-16s %10.2f %10.2f %9.2fx %8s", p_name, p_bulk->scalar_ns, p_bulk->batch_ns,
+          p_bulk->scalar_ns / p_bulk->batch_ns, p_bulk->matched ? "yes" : "NO" );
+  if ( p_bulk->pack_ns > 0.0 )
+  {
+    printf( "  (packing in and out %.2f ns/board)", p_bulk->pack_ns );
+  }
+  printf( "\n" );
+}
+
+
+/*
+ * main - runs the benchmark and reports the results.
+ */
+
+int main( int argc, char **argv )
+{
+  uint32_t        l_rounds = ( argc > 1 ) ? strtoul( argv[1], nullptr, 10 ) : BENCH_DEFAULT_ROUNDS;
+  bench_result_t  l_narrow, l_wide;
+  bench_bulk_t    l_batch, l_sliced;
+  uint64_t        l_big_checksum = 0;
+  double          l_big_moves;
+  bool            l_checked;
+
+  if ( !board_verify_tables() )
+  {
+    fprintf( stderr, "row tables failed verification\n" );
+    return 1;
+  }
+
+  /* Each shape with a fast path of its own, and a couple without. */
+  l_checked = bench_check<Board<4, 4, 4>>( "4x4, 4-bit" );
+  l_checked &= bench_check<Board<4, 4, 5>>( "4x4, 5-bit" );
+  l_checked &= bench_check<Board<3, 3, 4>>( "3x3, 4-bit" );
+  l_checked &= bench_check<Board<5, 4, 4>>( "5x4, 4-bit" );
+  if ( !l_checked )
+  {
+    return 1;
+  }
+
+  l_narrow = bench_run<Board<4, 4, 4>>( l_rounds );
+  l_wide = bench_run<Board<4, 4, 5>>( l_rounds );
+  l_big_moves = bench_moves( l_rounds, bench_pool<Board<4, 4, 5>>( true ), &l_big_checksum );
+
+  printf( "%-16s %14s %14s\n", "board", "moves/s", "games/s" );
+  printf( "%-16s %14.0f %14.1f\n", "4x4, 4-bit", l_narrow.moves_per_second, l_narrow.games_per_second );
+  printf( "%-16s %14.0f %14.1f\n", "4x4, 5-bit", l_wide.moves_per_second, l_wide.games_per_second );
+  printf( "5-bit cost: %.2fx slower moves, %.2fx slower games (checksums %016llx %016llx)\n",
+          l_narrow.moves_per_second / l_wide.moves_per_second,
+          l_narrow.games_per_second / l_wide.games_per_second,
+          (unsigned long long)l_narrow.checksum, (unsigned long long)l_wide.checksum );
+  printf( "%-16s %14.0f %14s\n", "  tiles >= 2^15", l_big_moves, "-" );
+  printf( "5-bit rows of four cells are too wide for tables of their own. While all\n"
+          "their tiles are below 2^15 they borrow the 4-bit ones; a row with a bigger\n"
+          "tile runs the slide kernel, and a board with one in every row moves %.2fx\n"
+          "slower than the 4-bit board (checksum %016llx).\n",
+          l_narrow.moves_per_second / l_big_moves, (unsigned long long)l_big_checksum );
+
+  /* The bulk moves, against the same moves a board at a time. */
+  l_batch = bench_bulk( l_rounds, board_move_batch<4, 4, 4> );
+  l_sliced = bench_bitslice( l_rounds );
+
+  printf( "\n%-16s %10s %10s %10s %8s\n", "bulk move", "slide ns", "bulk ns", "speedup", "matches" );
+  bench_report( "move_batch", &l_batch );
+  bench_report( "bitslice", &l_sliced );
+
+  return ( l_batch.matched && l_sliced.matched ) ? 0 : 1;
+}
+
+
+/* End of file tools/benchmark.cpp */
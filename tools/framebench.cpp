@@ -0,0 +1,175 @@
+/*
+ * tools/framebench.cpp; measures the cost of the game's own frames on the
+ * host, using the headless PicoSystem stand-in in host/.
+ *
+ * Runs the real init(), update() and draw() on a virtual 50Hz clock; it
+ * sits through the splash screen, starts games from the title screen and
+ * plays them with random presses, timing update() and draw() separately
+ * for each part of the game. The checksum of the final framebuffer shows
+ * whether a change to the drawing altered what ends up on screen.
+ *
+ * Usage: framebench [games]
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+/* System headers. */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+
+/* Local headers. */
+
+#include "picosystem.hpp"
+#include "engine/rng.hpp"
+
+
+/* Constants. */
+
+#define FRAME_US              20000
+#define FRAME_DEFAULT_GAMES   20
+#define FRAME_MAX_FRAMES      10000000
+#define FRAME_SEED            0x2040
+
+
+/* Local structures and types. */
+
+typedef enum
+{
+  PHASE_SPLASH,
+  PHASE_TITLE,
+  PHASE_PLAY,
+  PHASE_COUNT
+} phase_t;
+
+typedef struct
+{
+  uint64_t  frames;
+  uint64_t  update_ns;
+  uint64_t  draw_ns;
+} phase_cost_t;
+
+
+/* The game's state, which tells us which part of it we're timing. */
+
+extern bool         g_playing;
+extern bool         g_splashing;
+extern uint_fast8_t g_splash_tone;
+
+
+/* Functions. */
+
+/*
+ * frame_ns - returns the nanoseconds between two readings of the clock.
+ */
+
+static uint64_t frame_ns( std::chrono::steady_clock::time_point p_from,
+                          std::chrono::steady_clock::time_point p_to )
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>( p_to - p_from ).count();
+}
+
+
+/*
+ * frame_phase - works out which part of the game we're in.
+ */
+
+static phase_t frame_phase( void )
+{
+  if ( g_splashing || g_splash_tone > 0 )
+  {
+    return PHASE_SPLASH;
+  }
+  return g_playing ? PHASE_PLAY : PHASE_TITLE;
+}
+
+
+/*
+ * main - runs the game for the requested number of games, and reports the
+ *        cost of each part of it.
+ */
+
+int main( int argc, char **argv )
+{
+  static const char    *l_names[PHASE_COUNT] = { "splash", "title", "play" };
+  static const uint32_t l_directions[] = { picosystem::UP, picosystem::DOWN, picosystem::LEFT, picosystem::RIGHT };
+  uint32_t              l_games = ( argc > 1 ) ? strtoul( argv[1], nullptr, 10 ) : FRAME_DEFAULT_GAMES;
+  uint32_t              l_started = 0;
+  uint64_t              l_checksum = 0;
+  phase_cost_t          l_costs[PHASE_COUNT] = {};
+  phase_t               l_phase = PHASE_SPLASH, l_last_phase = PHASE_SPLASH;
+  rng_t                 l_rng;
+
+  host_reset();
+  init();
+  rng_seed( &l_rng, FRAME_SEED );
+
+  for ( uint32_t l_frame = 0; l_frame < FRAME_MAX_FRAMES; l_frame++ )
+  {
+    /* Count the games as they start, and stop at the end of the last. */
+    l_phase = frame_phase();
+    if ( l_phase == PHASE_PLAY && l_last_phase != PHASE_PLAY )
+    {
+      l_started++;
+    }
+    if ( l_phase == PHASE_TITLE && l_started >= l_games )
+    {
+      break;
+    }
+    l_last_phase = l_phase;
+
+    /* Buttons only register as they go down, so press on every other */
+    /* frame; start from the title, or play a random direction.       */
+    if ( l_frame & 1 )
+    {
+      host_buttons( 0 );
+    }
+    else if ( l_phase == PHASE_TITLE )
+    {
+      host_buttons( 1u << picosystem::A );
+    }
+    else if ( l_phase == PHASE_PLAY )
+    {
+      host_buttons( 1u << l_directions[rng_below( &l_rng, 4 )] );
+    }
+
+    /* Then run the frame, timing each half of it. */
+    host_tick( FRAME_US );
+    auto l_start = std::chrono::steady_clock::now();
+    update( l_frame );
+    auto l_updated = std::chrono::steady_clock::now();
+    draw( l_frame );
+    auto l_drawn = std::chrono::steady_clock::now();
+
+    l_costs[l_phase].frames++;
+    l_costs[l_phase].update_ns += frame_ns( l_start, l_updated );
+    l_costs[l_phase].draw_ns += frame_ns( l_updated, l_drawn );
+  }
+
+  /* Sum up the final screen, so drawing changes can be checked. */
+  for ( int32_t l_index = 0; l_index < picosystem::SCREEN->w * picosystem::SCREEN->h; l_index++ )
+  {
+    l_checksum = ( l_checksum ^ picosystem::SCREEN->data[l_index] ) * 0x100000001B3ull;
+  }
+
+  printf( "%-8s %10s %14s %14s\n", "phase", "frames", "update ns/f", "draw ns/f" );
+  for ( uint_fast8_t l_index = 0; l_index < PHASE_COUNT; l_index++ )
+  {
+    double l_frames = l_costs[l_index].frames ? l_costs[l_index].frames : 1;
+
+    printf( "%-8s %10llu %14.0f %14.0f\n", l_names[l_index],
+            (unsigned long long)l_costs[l_index].frames,
+            l_costs[l_index].update_ns / l_frames, l_costs[l_index].draw_ns / l_frames );
+  }
+  printf( "%u games, %u sounds, screen checksum %016llx\n",
+          l_started, host_sounds(), (unsigned long long)l_checksum );
+
+  return 0;
+}
+
+
+/* End of file tools/framebench.cpp */
@@ -0,0 +1,250 @@
+/*
+ * tools/searchbench.cpp; measures how the search scales with threads.
+ *
+ * Plays a game with a shallow search to collect a spread of positions, from
+ * the opening to the crowded late game, then searches every one of them to
+ * the requested depth with 1, 2, 4 ... threads, each time with a fresh
+ * transposition table, and reports the time taken and the speed-up over a
+ * single thread. Threads race to fill the table, so a handful of close
+ * decisions can come out differently; those are counted too, against the
+ * exact search.
+ *
+ * A single-threaded search with no pruning at all goes first, so that the
+ * nodes saved (and the decisions changed) by the probability cutoff and
+ * the limit on '4's can be seen alongside the speed-up.
+ *
+ * Last of all comes search_timed(), single-threaded and without a table as
+ * it is on the device, and given a budget of time instead of a depth; for
+ * that, it reports the depth reached, how far past its budget it ran, and
+ * how often it chose differently from the exact search.
+ *
+ * Usage: searchbench [depth [max threads [positions [budget ms]]]]
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+/* System headers. */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+
+/* Local headers. */
+
+#include "engine/board.hpp"
+#include "engine/game.hpp"
+#include "engine/platform.hpp"
+#include "engine/pool.hpp"
+#include "engine/search.hpp"
+#include "engine/ttable.hpp"
+
+
+/* Constants. */
+
+#define BENCH_DEFAULT_DEPTH     5
+#define BENCH_DEFAULT_POSITIONS 20
+#define BENCH_PLAY_DEPTH        2
+#define BENCH_DEFAULT_BUDGET_MS 10
+#define BENCH_SEED              0x2040
+
+
+/* Local structures and types. */
+
+typedef Board<4, 4> bench_board_t;
+
+typedef struct
+{
+  double    seconds;
+  uint64_t  nodes;
+} bench_run_t;
+
+
+/* Functions. */
+
+/*
+ * bench_positions - plays a game, keeping p_count positions spread evenly
+ *                   along it.
+ */
+
+static std::vector<bench_board_t> bench_positions( uint32_t p_count )
+{
+  game_t<bench_board_t>       l_game;
+  std::vector<bench_board_t>  l_played, l_chosen;
+
+  game_reset( &l_game, BENCH_SEED );
+  while( game_spawn( &l_game ) && ( l_game.legal != 0 ) )
+  {
+    l_played.push_back( l_game.board );
+    game_move( &l_game, search_best( l_game.board, BENCH_PLAY_DEPTH ).direction );
+  }
+
+  for ( uint32_t l_index = 0; l_index < p_count && !l_played.empty(); l_index++ )
+  {
+    l_chosen.push_back( l_played[( l_index * l_played.size() ) / p_count] );
+  }
+  return l_chosen;
+}
+
+
+/*
+ * bench_search - searches every position with the given options and a fresh
+ *                table, and reports on it. The first run fills in the
+ *                reference moves, and later ones are compared against them.
+ */
+
+static bench_run_t bench_search( const char *p_label, const std::vector<bench_board_t> &p_positions,
+                                 search_options_t *p_options, std::vector<direction_t> *p_reference,
+                                 const bench_run_t *p_exact, const bench_run_t *p_single )
+{
+  bench_run_t l_run = {};
+  uint64_t    l_hits = 0, l_pruned = 0, l_capped = 0, l_start;
+  uint32_t    l_differ = 0;
+
+  p_options->table = ttable_create();
+  if ( p_options->table == nullptr )
+  {
+    fprintf( stderr, "no memory for the transposition table\n" );
+    exit( 1 );
+  }
+
+  l_start = platform_time_us();
+  for ( uint32_t l_index = 0; l_index < p_positions.size(); l_index++ )
+  {
+    search_result_t l_result = search_best( p_positions[l_index], p_options );
+
+    l_run.nodes += l_result.nodes;
+    l_hits += l_result.table_hits;
+    l_pruned += l_result.pruned;
+    l_capped += l_result.capped;
+    if ( p_reference->size() < p_positions.size() )
+    {
+      p_reference->push_back( l_result.direction );
+    }
+    else if ( l_result.direction != ( *p_reference )[l_index] )
+    {
+      l_differ++;
+    }
+  }
+  l_run.seconds = ( platform_time_us() - l_start ) / 1000000.0;
+
+  printf( "%8s %10.3f %12.2f %14.0f %9.1f%% %12llu %12llu %12lld %7.2fx %8u\n", p_label, l_run.seconds,
+          1000.0 * l_run.seconds / p_positions.size(), l_run.nodes / l_run.seconds,
+          l_run.nodes ? ( 100.0 * l_hits ) / l_run.nodes : 0.0, (unsigned long long)l_pruned,
+          (unsigned long long)l_capped,
+          p_exact ? (long long)( p_exact->nodes - l_run.nodes ) : 0LL,
+          p_single ? p_single->seconds / l_run.seconds : 1.0, l_differ );
+
+  ttable_destroy( p_options->table );
+  p_options->table = nullptr;
+  return l_run;
+}
+
+
+/*
+ * bench_timed - gives every position a search_timed() with the given budget,
+ *               set up as the device sets it up, and reports on it against
+ *               the moves of the exact search.
+ */
+
+static void bench_timed( const std::vector<bench_board_t> &p_positions, uint32_t p_budget_us,
+                         const std::vector<direction_t> &p_reference )
+{
+  search_options_t  l_options = search_options( 0 );
+  uint64_t          l_nodes = 0, l_depths = 0, l_total_us = 0, l_worst_us = 0;
+  uint32_t          l_differ = 0;
+
+  for ( uint32_t l_index = 0; l_index < p_positions.size(); l_index++ )
+  {
+    uint64_t        l_start = platform_time_us();
+    search_result_t l_result = search_timed( p_positions[l_index], &l_options, p_budget_us );
+    uint64_t        l_taken = platform_time_us() - l_start;
+
+    l_nodes += l_result.nodes;
+    l_depths += l_result.depth;
+    l_total_us += l_taken;
+    if ( l_taken > l_worst_us )
+    {
+      l_worst_us = l_taken;
+    }
+    if ( l_result.direction != p_reference[l_index] )
+    {
+      l_differ++;
+    }
+  }
+
+  printf( "\ntimed search, %.1fms budget\n", p_budget_us / 1000.0 );
+  printf( "%10s %12s %12s %14s %8s\n", "depth", "ms/search", "worst ms", "nodes/s", "differ" );
+  printf( "%10.2f %12.2f %12.2f %14.0f %8u\n", (double)l_depths / p_positions.size(),
+          l_total_us / 1000.0 / p_positions.size(), l_worst_us / 1000.0,
+          l_total_us ? l_nodes * 1000000.0 / l_total_us : 0.0, l_differ );
+}
+
+
+/*
+ * main - runs the searches for each thread count, and reports the curve.
+ */
+
+int main( int argc, char **argv )
+{
+  uint32_t                    l_depth = ( argc > 1 ) ? strtoul( argv[1], nullptr, 10 ) : BENCH_DEFAULT_DEPTH;
+  uint32_t                    l_max = ( argc > 2 ) ? strtoul( argv[2], nullptr, 10 ) : 0;
+  uint32_t                    l_count = ( argc > 3 ) ? strtoul( argv[3], nullptr, 10 ) : BENCH_DEFAULT_POSITIONS;
+  uint32_t                    l_budget = ( argc > 4 ) ? strtoul( argv[4], nullptr, 10 ) : BENCH_DEFAULT_BUDGET_MS;
+  std::vector<bench_board_t>  l_positions = bench_positions( l_count );
+  std::vector<direction_t>    l_reference;
+  search_options_t            l_options;
+  bench_run_t                 l_exact, l_single;
+  char                        l_label[16];
+
+  if ( l_max == 0 )
+  {
+    l_max = std::thread::hardware_concurrency();
+    if ( l_max == 0 )
+    {
+      l_max = 1;
+    }
+  }
+
+  printf( "depth %u over %zu positions\n", l_depth, l_positions.size() );
+  printf( "%8s %10s %12s %14s %10s %12s %12s %12s %8s %8s\n", "threads", "seconds", "ms/search",
+          "nodes/s", "hit rate", "pruned", "capped 4s", "nodes saved", "speedup", "differ" );
+
+  /* The full search, with nothing pruned, is the reference. */
+  l_options = search_options( l_depth );
+  l_options.cutoff = 0.0;
+  l_options.max_fours = UINT8_MAX;
+  l_exact = bench_search( "exact", l_positions, &l_options, &l_reference, nullptr, nullptr );
+
+  /* Then double the threads each time, finishing on the most allowed. */
+  for ( uint32_t l_threads = 1; ; l_threads = ( l_threads * 2 < l_max ) ? l_threads * 2 : l_max )
+  {
+    l_options = search_options( l_depth, nullptr, pool_create( l_threads ) );
+    snprintf( l_label, sizeof( l_label ), "%u", l_threads );
+    if ( l_threads == 1 )
+    {
+      l_single = bench_search( l_label, l_positions, &l_options, &l_reference, &l_exact, nullptr );
+    }
+    else
+    {
+      bench_search( l_label, l_positions, &l_options, &l_reference, &l_exact, &l_single );
+    }
+    pool_destroy( l_options.pool );
+
+    if ( l_threads == l_max )
+    {
+      break;
+    }
+  }
+
+  /* And the anytime search, as hints and autoplay use it. */
+  bench_timed( l_positions, l_budget * 1000, l_reference );
+
+  return 0;
+}
+
+
+/* End of file tools/searchbench.cpp */
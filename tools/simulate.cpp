@@ -0,0 +1,254 @@
+/*
+ * tools/simulate.cpp; plays complete games headlessly, on every core.
+ *
+ * Each worker thread has its own board, game and stream of random numbers
+ * (carved from the one seed with rng_stream(), so no two overlap), and plays
+ * its share of the games with the chosen policy. At the end the workers'
+ * tallies are added up into games and moves per second, the average score
+ * and the distribution of the largest tile reached. The same seed, policy
+ * and thread count always play exactly the same games.
+ *
+ * Usage: simulate [games [threads [policy [seed]]]]
+ *
+ * Copyright (c) 2021 Pete Favelle <picosystem@ahnlak.com>
+ * This file is distributed under the MIT License; see LICENSE for details.
+ */
+
+/* System headers. */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+
+/* Local headers. */
+
+#include "engine/bits.hpp"
+#include "engine/board.hpp"
+#include "engine/game.hpp"
+#include "engine/platform.hpp"
+#include "engine/rng.hpp"
+#include "engine/search.hpp"
+
+
+/* Constants. */
+
+#define SIM_DEFAULT_GAMES   100000
+#define SIM_DEFAULT_SEED    0x2040
+#define SIM_SEARCH_DEPTH    2
+
+
+/* Local structures and types. */
+
+typedef Board<4, 4> sim_board_t;
+typedef game_t<sim_board_t> sim_game_t;
+
+typedef direction_t (*sim_policy_t)( const sim_game_t *p_game, rng_t *p_rng );
+
+typedef struct
+{
+  const char   *name;
+  sim_policy_t  choose;
+} sim_policy_entry_t;
+
+struct alignas( 64 ) sim_tally_t
+{
+  uint64_t  games;
+  uint64_t  moves;
+  uint64_t  score;
+  uint64_t  max_tiles[BOARD_MAX_EXP + 1];
+};
+
+
+/* Functions. */
+
+/*
+ * sim_random - picks any legal move, at random.
+ */
+
+static direction_t sim_random( const sim_game_t *p_game, rng_t *p_rng )
+{
+  return (direction_t)bits_select( p_game->legal, rng_below( p_rng, bits_count( p_game->legal ) ) );
+}
+
+
+/*
+ * sim_greedy - picks the legal move which scores most right now, breaking
+ *              ties in favour of the one leaving most empty cells.
+ */
+
+static direction_t sim_greedy( const sim_game_t *p_game, rng_t *p_rng )
+{
+  direction_t   l_best = DIRECTION_COUNT;
+  uint64_t      l_best_score = 0;
+  uint_fast8_t  l_best_empty = 0;
+
+  (void)p_rng;
+
+  for ( uint_fast8_t l_dir = 0; l_dir < DIRECTION_COUNT; l_dir++ )
+  {
+    if ( ( p_game->legal & DIRECTION_BIT( l_dir ) ) == 0 )
+    {
+      continue;
+    }
+
+    move_result_t<sim_board_t> l_moved = p_game->board.move( (direction_t)l_dir );
+    uint_fast8_t               l_empty = bits_count( l_moved.empty );
+
+    if ( l_best == DIRECTION_COUNT || l_moved.score > l_best_score ||
+         ( l_moved.score == l_best_score && l_empty > l_best_empty ) )
+    {
+      l_best = (direction_t)l_dir;
+      l_best_score = l_moved.score;
+      l_best_empty = l_empty;
+    }
+  }
+
+  return l_best;
+}
+
+
+/*
+ * sim_expectimax - picks the move an expectimax search of SIM_SEARCH_DEPTH
+ *                  moves thinks best.
+ */
+
+static direction_t sim_expectimax( const sim_game_t *p_game, rng_t *p_rng )
+{
+  (void)p_rng;
+
+  return search_best( p_game->board, SIM_SEARCH_DEPTH ).direction;
+}
+
+
+/* The policies, by the name they're asked for with. */
+
+static const sim_policy_entry_t g_sim_policies[] =
+{
+  { "random", sim_random },
+  { "greedy", sim_greedy },
+  { "expectimax", sim_expectimax },
+};
+
+
+/*
+ * sim_worker - plays p_games games on one thread, using its own stream of
+ *              random numbers both to seed the games and for the policy.
+ */
+
+static void sim_worker( sim_policy_t p_policy, uint64_t p_seed, uint32_t p_stream,
+                        uint64_t p_games, sim_tally_t *p_tally )
+{
+  sim_game_t  l_game;
+  rng_t       l_rng;
+
+  rng_stream( &l_rng, p_seed, p_stream );
+
+  for ( uint64_t l_index = 0; l_index < p_games; l_index++ )
+  {
+    game_reset( &l_game, ( (uint64_t)rng_next( &l_rng ) << 32 ) | rng_next( &l_rng ) );
+    while( game_spawn( &l_game ) && ( l_game.legal != 0 ) )
+    {
+      game_move( &l_game, p_policy( &l_game, &l_rng ) );
+    }
+
+    p_tally->games++;
+    p_tally->moves += l_game.moves;
+    p_tally->score += l_game.score;
+    p_tally->max_tiles[l_game.max_exponent]++;
+  }
+}
+
+
+/*
+ * main - shares the games out between the threads, and reports on them.
+ */
+
+int main( int argc, char **argv )
+{
+  uint64_t                  l_games = ( argc > 1 ) ? strtoull( argv[1], nullptr, 10 ) : SIM_DEFAULT_GAMES;
+  uint32_t                  l_threads = ( argc > 2 ) ? strtoul( argv[2], nullptr, 10 ) : 0;
+  const char               *l_name = ( argc > 3 ) ? argv[3] : g_sim_policies[0].name;
+  uint64_t                  l_seed = ( argc > 4 ) ? strtoull( argv[4], nullptr, 0 ) : SIM_DEFAULT_SEED;
+  sim_policy_t              l_policy = nullptr;
+  sim_tally_t               l_total = {};
+  std::vector<sim_tally_t>  l_tallies;
+  std::vector<std::thread>  l_workers;
+  uint64_t                  l_start;
+  double                    l_seconds;
+
+  for ( const sim_policy_entry_t &l_entry : g_sim_policies )
+  {
+    if ( strcmp( l_entry.name, l_name ) == 0 )
+    {
+      l_policy = l_entry.choose;
+    }
+  }
+  if ( l_policy == nullptr )
+  {
+    fprintf( stderr, "unknown policy '%s'\n", l_name );
+    return 1;
+  }
+
+  /* Default to one thread per core. */
+  if ( l_threads == 0 )
+  {
+    l_threads = std::thread::hardware_concurrency();
+    if ( l_threads == 0 )
+    {
+      l_threads = 1;
+    }
+  }
+  l_tallies.resize( l_threads, sim_tally_t() );
+
+  /* Every thread gets an equal share of the games, near enough. */
+  l_start = platform_time_us();
+  for ( uint32_t l_thread = 0; l_thread < l_threads; l_thread++ )
+  {
+    uint64_t l_share = l_games / l_threads + ( ( l_thread < l_games % l_threads ) ? 1 : 0 );
+
+    l_workers.emplace_back( sim_worker, l_policy, l_seed, l_thread, l_share, &l_tallies[l_thread] );
+  }
+  for ( std::thread &l_worker : l_workers )
+  {
+    l_worker.join();
+  }
+  l_seconds = ( platform_time_us() - l_start ) / 1000000.0;
+
+  /* Add it all up. */
+  for ( const sim_tally_t &l_tally : l_tallies )
+  {
+    l_total.games += l_tally.games;
+    l_total.moves += l_tally.moves;
+    l_total.score += l_tally.score;
+    for ( uint_fast8_t l_exp = 0; l_exp <= BOARD_MAX_EXP; l_exp++ )
+    {
+      l_total.max_tiles[l_exp] += l_tally.max_tiles[l_exp];
+    }
+  }
+
+  printf( "%llu %s games on %u threads in %.2fs\n",
+          (unsigned long long)l_total.games, l_name, l_threads, l_seconds );
+  printf( "%.1f games/s, %.0f moves/s, average score %.1f, average length %.1f moves\n",
+          l_total.games / l_seconds, l_total.moves / l_seconds,
+          l_total.games ? (double)l_total.score / l_total.games : 0.0,
+          l_total.games ? (double)l_total.moves / l_total.games : 0.0 );
+
+  printf( "%8s %12s %8s\n", "max tile", "games", "share" );
+  for ( uint_fast8_t l_exp = 1; l_exp <= BOARD_MAX_EXP; l_exp++ )
+  {
+    if ( l_total.max_tiles[l_exp] > 0 )
+    {
+      printf( "%8u %12llu %7.3f%%\n", 1u << l_exp, (unsigned long long)l_total.max_tiles[l_exp],
+              100.0 * l_total.max_tiles[l_exp] / l_total.games );
+    }
+  }
+
+  return 0;
+}
+
+
+/* End of file tools/simulate.cpp */